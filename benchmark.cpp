@@ -0,0 +1,759 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "json_file.h"
+
+using namespace json;
+using namespace std::literals;
+
+namespace
+{
+  // Количество и суммарный объём выделений памяти через operator new
+  std::atomic<size_t> alloc_count{0};
+  std::atomic<size_t> alloc_bytes{0};
+  // Объём памяти, выделенной и ещё не освобождённой. Размер блока хранится в заголовке перед ним,
+  // поэтому счётчик не зависит от распределителя, но и не учитывает округление размеров блоков
+  std::atomic<size_t> live_bytes{0};
+  // Заголовок сохраняет выравнивание, которое гарантирует operator new
+  constexpr size_t kHeaderSize = alignof(std::max_align_t);
+} // namespace
+
+void *operator new(size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *block = std::malloc(kHeaderSize + size))
+  {
+    *static_cast<size_t *>(block) = size;
+    live_bytes.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char *>(block) + kHeaderSize;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return operator new(size);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return nullptr;
+  }
+}
+
+void operator delete(void *ptr) noexcept
+{
+  if (ptr == nullptr)
+  {
+    return;
+  }
+  void *block = static_cast<char *>(ptr) - kHeaderSize;
+  live_bytes.fetch_sub(*static_cast<size_t *>(block), std::memory_order_relaxed);
+  std::free(block);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+  operator delete(ptr);
+}
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  double SecondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  enum class Format
+  {
+    // Один документ — массив элементов
+    Document,
+    // JSON Lines: по элементу в строке
+    Lines,
+  };
+
+  // Дописывает в out очередной элемент корпуса
+  using ItemGenerator = void (*)(std::string &out, std::mt19937_64 &random);
+
+  struct CorpusKind
+  {
+    std::string_view name;
+    Format format;
+    ItemGenerator generate;
+  };
+
+  void AppendNumber(std::string &out, double value)
+  {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+  }
+
+  void AppendWord(std::string &out, std::mt19937_64 &random)
+  {
+    static constexpr std::string_view kWords[] = {"lorem"sv, "ipsum"sv, "dolor"sv, "sit"sv, "amet"sv, "consectetur"sv,
+                                                  "adipiscing"sv, "elit"sv, "sed"sv, "do"sv, "eiusmod"sv, "tempor"sv};
+    out += kWords[random() % std::size(kWords)];
+  }
+
+  // Строки чисел: целые разной длины и дробные
+  void GenerateNumbers(std::string &out, std::mt19937_64 &random)
+  {
+    out += '[';
+    for (int i = 0; i < 16; ++i)
+    {
+      if (i != 0)
+      {
+        out += ',';
+      }
+      switch (random() % 3)
+      {
+      case 0:
+        out += std::to_string(static_cast<int>(random() % 2000000) - 1000000);
+        break;
+      case 1:
+        out += std::to_string(static_cast<int64_t>(random() >> 1));
+        break;
+      default:
+        AppendNumber(out, std::uniform_real_distribution<double>(-1e6, 1e6)(random));
+        break;
+      }
+    }
+    out += ']';
+  }
+
+  // Длинные текстовые поля с редкими escape-последовательностями
+  void GenerateStrings(std::string &out, std::mt19937_64 &random)
+  {
+    static constexpr std::string_view kEscapes[] = {"\\n"sv, "\\t"sv, "\\\""sv, "\\\\"sv};
+    const size_t length = 32 + random() % 2048;
+    out += '"';
+    const size_t start = out.size();
+    while (out.size() - start < length)
+    {
+      AppendWord(out, random);
+      out += random() % 16 == 0 ? kEscapes[random() % std::size(kEscapes)] : " "sv;
+    }
+    out += '"';
+  }
+
+  // Глубоко вложенные словари и массивы, в пределах ограничения глубины по умолчанию
+  void GenerateNested(std::string &out, std::mt19937_64 &random)
+  {
+    constexpr int kDepth = 100;
+    for (int i = 0; i < kDepth; ++i)
+    {
+      out += "{\"level\":["sv;
+    }
+    out += std::to_string(random() % 1000);
+    for (int i = 0; i < kDepth; ++i)
+    {
+      out += "]}"sv;
+    }
+  }
+
+  // Словари с тысячей ключей
+  void GenerateWide(std::string &out, std::mt19937_64 &random)
+  {
+    out += '{';
+    for (int i = 0; i < 1000; ++i)
+    {
+      if (i != 0)
+      {
+        out += ',';
+      }
+      out += "\"field_"sv;
+      out += std::to_string(i);
+      out += "\":"sv;
+      if (i % 2 == 0)
+      {
+        out += std::to_string(random() % 100000);
+      }
+      else
+      {
+        out += '"';
+        AppendWord(out, random);
+        out += '"';
+      }
+    }
+    out += '}';
+  }
+
+  // Записи журнала в формате JSON Lines
+  void GenerateRecord(std::string &out, std::mt19937_64 &random)
+  {
+    static constexpr std::string_view kLevels[] = {"debug"sv, "info"sv, "warning"sv, "error"sv};
+    out += "{\"ts\":"sv;
+    out += std::to_string(1700000000000 + random() % 100000000);
+    out += ",\"level\":\""sv;
+    out += kLevels[random() % std::size(kLevels)];
+    out += "\",\"user\":{\"id\":"sv;
+    out += std::to_string(random() % 1000000);
+    out += ",\"name\":\"user_"sv;
+    out += std::to_string(random() % 1000);
+    out += "\"},\"message\":\""sv;
+    for (int i = 0; i < 8; ++i)
+    {
+      AppendWord(out, random);
+      out += ' ';
+    }
+    out += "\",\"tags\":[\"api\",\"v2\"],\"latency_ms\":"sv;
+    AppendNumber(out, static_cast<double>(random() % 100000) / 100);
+    out += ",\"ok\":"sv;
+    out += random() % 10 != 0 ? "true"sv : "false"sv;
+    out += '}';
+  }
+
+  constexpr CorpusKind kCorpora[] = {
+      {"numbers"sv, Format::Document, GenerateNumbers},
+      {"strings"sv, Format::Document, GenerateStrings},
+      {"nested"sv, Format::Document, GenerateNested},
+      {"wide"sv, Format::Document, GenerateWide},
+      {"ndjson"sv, Format::Lines, GenerateRecord},
+  };
+
+  // Строит корпус размером не меньше size байт (и не меньше одного элемента)
+  std::string GenerateCorpus(const CorpusKind &kind, size_t size)
+  {
+    std::mt19937_64 random(42);
+    std::string text;
+    text.reserve(size + 4096);
+    if (kind.format == Format::Document)
+    {
+      text += '[';
+      do
+      {
+        if (text.size() > 1)
+        {
+          text += ',';
+        }
+        kind.generate(text, random);
+      } while (text.size() + 1 < size);
+      text += ']';
+    }
+    else
+    {
+      do
+      {
+        kind.generate(text, random);
+        text += '\n';
+      } while (text.size() < size);
+    }
+    return text;
+  }
+
+  size_t CountNodes(const Node &node)
+  {
+    size_t count = 1;
+    if (node.IsArray())
+    {
+      for (const Node &item : node.AsArray())
+      {
+        count += CountNodes(item);
+      }
+    }
+    else if (node.IsMap())
+    {
+      for (const auto &[key, value] : node.AsMap())
+      {
+        count += CountNodes(value);
+      }
+    }
+    return count;
+  }
+
+  // Вызывает f для каждой непустой строки text
+  template <typename F>
+  void ForEachLine(std::string_view text, F &&f)
+  {
+    while (!text.empty())
+    {
+      const size_t newline = std::min(text.find('\n'), text.size());
+      if (newline != 0)
+      {
+        f(text.substr(0, newline));
+      }
+      text.remove_prefix(std::min(newline + 1, text.size()));
+    }
+  }
+
+  // Строки записанного потока, которые удалось разобрать, и размер отброшенных
+  struct ReplayLines
+  {
+    std::string text;
+    size_t skipped_lines = 0;
+    size_t skipped_bytes = 0;
+  };
+
+  // Проверяет строки записанного потока. Строку, которую библиотека не разбирает (например,
+  // с escape-последовательностью \uXXXX), замер либо отвергает, либо при skip_invalid
+  // пропускает и учитывает в результатах, чтобы было видно, какая доля входа не измерена
+  ReplayLines ParsableLines(std::string_view text, bool skip_invalid)
+  {
+    ReplayLines result;
+    size_t number = 0;
+    ForEachLine(text, [&](std::string_view line)
+                {
+                  ++number;
+                  const auto parsed = json::TryLoad(line);
+                  if (parsed)
+                  {
+                    result.text.append(line);
+                    result.text += '\n';
+                    return;
+                  }
+                  if (!skip_invalid)
+                  {
+                    throw std::runtime_error("line "s + std::to_string(number) + ", column "s +
+                                             std::to_string(parsed.GetError().column) + ": "s + parsed.GetError().Message() +
+                                             " (--skip-invalid measures the remaining lines)"s);
+                  }
+                  ++result.skipped_lines;
+                  // Вместе с переводом строки, как и у разобранных строк
+                  result.skipped_bytes += line.size() + 1; });
+    if (result.text.empty())
+    {
+      throw std::runtime_error("no parsable lines");
+    }
+    return result;
+  }
+
+  // Результаты одного замера. Передаются из дочернего процесса как есть, поэтому без указателей
+  struct Measurement
+  {
+    size_t input_bytes = 0;
+    size_t output_bytes = 0;
+    size_t nodes = 0;
+    double parse_seconds = 0;
+    double print_seconds = 0;
+    // Выделения памяти за один разбор всего корпуса
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+    // Память, которую занимают разобранные документы, без учёта округления блоков распределителем
+    size_t document_bytes = 0;
+    // Строки записанного потока, пропущенные из-за ошибок разбора, и их объём
+    size_t skipped_lines = 0;
+    size_t skipped_bytes = 0;
+    long peak_rss_kb = 0;
+  };
+
+  // Повторяет замер, пока суммарное время не превысит min_time, и возвращает медиану.
+  // run возвращает время одного повтора, чтобы не учитывать подготовку и освобождение памяти
+  template <typename F>
+  double MedianSeconds(F &&run, double min_time)
+  {
+    constexpr size_t kMaxRepeats = 1000;
+    std::vector<double> times;
+    double total = 0;
+    do
+    {
+      times.push_back(run());
+      total += times.back();
+    } while (total < min_time && times.size() < kMaxRepeats);
+    const auto middle = times.begin() + times.size() / 2;
+    std::nth_element(times.begin(), middle, times.end());
+    return *middle;
+  }
+
+  Measurement MeasureDocument(std::string_view text, double min_time)
+  {
+    Measurement result;
+    result.input_bytes = text.size();
+
+    const size_t count_before = alloc_count;
+    const size_t bytes_before = alloc_bytes;
+    const size_t live_before = live_bytes;
+    const Document doc = json::Load(text);
+    result.allocations = alloc_count - count_before;
+    result.allocated_bytes = alloc_bytes - bytes_before;
+    result.document_bytes = live_bytes - live_before;
+    result.nodes = CountNodes(doc.GetRoot());
+
+    result.parse_seconds = MedianSeconds([text]
+                                         {
+                                           const auto start = Clock::now();
+                                           const Document parsed = json::Load(text);
+                                           return SecondsSince(start); },
+                                         min_time);
+
+    std::string output;
+    output.reserve(text.size());
+    result.print_seconds = MedianSeconds([&doc, &output]
+                                         {
+                                           output.clear();
+                                           const auto start = Clock::now();
+                                           json::Print(doc, output);
+                                           return SecondsSince(start); },
+                                         min_time);
+    result.output_bytes = output.size();
+    return result;
+  }
+
+  Measurement MeasureLines(std::string_view text, double min_time)
+  {
+    Measurement result;
+    result.input_bytes = text.size();
+
+    Loader loader;
+    std::vector<Document> docs;
+    const size_t count_before = alloc_count;
+    const size_t bytes_before = alloc_bytes;
+    const size_t live_before = live_bytes;
+    ForEachLine(text, [&loader, &docs](std::string_view line)
+                { docs.push_back(loader.Load(line)); });
+    result.allocations = alloc_count - count_before;
+    result.allocated_bytes = alloc_bytes - bytes_before;
+    result.document_bytes = live_bytes - live_before;
+    for (const Document &doc : docs)
+    {
+      result.nodes += CountNodes(doc.GetRoot());
+    }
+
+    result.parse_seconds = MedianSeconds([text, &loader]
+                                         {
+                                           const auto start = Clock::now();
+                                           ForEachLine(text, [&loader](std::string_view line)
+                                                       { loader.Load(line); });
+                                           return SecondsSince(start); },
+                                         min_time);
+
+    std::string output;
+    output.reserve(text.size());
+    result.print_seconds = MedianSeconds([&docs, &output]
+                                         {
+                                           output.clear();
+                                           const auto start = Clock::now();
+                                           for (const Document &doc : docs)
+                                           {
+                                             json::Print(doc, output);
+                                             output += '\n';
+                                           }
+                                           return SecondsSince(start); },
+                                         min_time);
+    result.output_bytes = output.size();
+    return result;
+  }
+
+  // Выполняет замер в дочернем процессе, чтобы пиковый объём памяти относился только к нему
+  template <typename F>
+  Measurement RunIsolated(F &&measure)
+  {
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+      throw std::runtime_error("pipe failed");
+    }
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+      throw std::runtime_error("fork failed");
+    }
+    if (pid == 0)
+    {
+      close(fds[0]);
+      int code = 0;
+      try
+      {
+        const Measurement result = measure();
+        code = write(fds[1], &result, sizeof(result)) == sizeof(result) ? 0 : 1;
+      }
+      catch (const std::exception &e)
+      {
+        std::cerr << "error: "sv << e.what() << std::endl;
+        code = 1;
+      }
+      _exit(code);
+    }
+
+    close(fds[1]);
+    Measurement result;
+    const bool received = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      throw std::runtime_error("measurement process failed");
+    }
+    result.peak_rss_kb = usage.ru_maxrss;
+    return result;
+  }
+
+  struct Options
+  {
+    std::vector<std::string_view> corpora;
+    size_t min_size = 1 << 10;
+    size_t max_size = 64 << 20;
+    double min_time = 0.5;
+    std::optional<std::string> replay;
+    bool skip_invalid = false;
+    bool json = false;
+  };
+
+  // Размер с необязательным суффиксом K, M или G
+  std::optional<size_t> ParseSize(std::string_view text)
+  {
+    size_t value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{})
+    {
+      return std::nullopt;
+    }
+    const std::string_view suffix(end, text.data() + text.size() - end);
+    if (suffix.empty())
+    {
+      return value;
+    }
+    if (suffix.size() != 1)
+    {
+      return std::nullopt;
+    }
+    switch (suffix[0])
+    {
+    case 'K':
+    case 'k':
+      return value << 10;
+    case 'M':
+    case 'm':
+      return value << 20;
+    case 'G':
+    case 'g':
+      return value << 30;
+    default:
+      return std::nullopt;
+    }
+  }
+
+  void PrintUsage(std::ostream &out)
+  {
+    out << "Usage: json_benchmark [options]\n"
+           "  --corpus LIST     comma-separated corpora: numbers,strings,nested,wide,ndjson (default: all)\n"
+           "  --min-size SIZE   smallest corpus size, K/M/G suffixes allowed (default: 1K)\n"
+           "  --max-size SIZE   largest corpus size, up to 1G (default: 64M)\n"
+           "  --time SECONDS    minimal total time of each measurement (default: 0.5)\n"
+           "  --replay FILE     measure a JSON Lines file, e.g. requests.jsonl, instead of generated corpora.\n"
+           "                    Fails on the first line the library cannot parse, e.g. one with a \\uXXXX escape\n"
+           "  --skip-invalid    with --replay, skip such lines and report their number and share of input bytes\n"
+           "  --json            print results as JSON Lines\n";
+  }
+
+  std::optional<Options> ParseArguments(int argc, char **argv)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      const std::string_view arg = argv[i];
+      if (arg == "--json"sv)
+      {
+        options.json = true;
+        continue;
+      }
+      if (arg == "--skip-invalid"sv)
+      {
+        options.skip_invalid = true;
+        continue;
+      }
+      if (i + 1 == argc)
+      {
+        return std::nullopt;
+      }
+      const std::string_view value = argv[++i];
+      if (arg == "--corpus"sv)
+      {
+        for (std::string_view rest = value; !rest.empty();)
+        {
+          const size_t comma = std::min(rest.find(','), rest.size());
+          const std::string_view name = rest.substr(0, comma);
+          if (std::none_of(std::begin(kCorpora), std::end(kCorpora), [name](const CorpusKind &kind)
+                           { return kind.name == name; }))
+          {
+            return std::nullopt;
+          }
+          options.corpora.push_back(name);
+          rest.remove_prefix(std::min(comma + 1, rest.size()));
+        }
+      }
+      else if (arg == "--min-size"sv || arg == "--max-size"sv)
+      {
+        const auto size = ParseSize(value);
+        if (!size || *size == 0)
+        {
+          return std::nullopt;
+        }
+        (arg == "--min-size"sv ? options.min_size : options.max_size) = *size;
+      }
+      else if (arg == "--time"sv)
+      {
+        options.min_time = std::atof(std::string(value).c_str());
+      }
+      else if (arg == "--replay"sv)
+      {
+        options.replay = std::string(value);
+      }
+      else
+      {
+        return std::nullopt;
+      }
+    }
+    return options;
+  }
+
+  std::string FormatSize(size_t size)
+  {
+    if (size >= (1 << 30))
+    {
+      return std::to_string(size >> 30) + "G"s;
+    }
+    if (size >= (1 << 20))
+    {
+      return std::to_string(size >> 20) + "M"s;
+    }
+    return std::to_string(size >> 10) + "K"s;
+  }
+
+  double MegabytesPerSecond(size_t bytes, double seconds)
+  {
+    return static_cast<double>(bytes) / (1 << 20) / seconds;
+  }
+
+  void PrintHeader()
+  {
+    std::cout << "sizeof(Node): "sv << sizeof(Node) << " bytes"sv << std::endl;
+    std::cout << std::left << std::setw(10) << "corpus" << std::right << std::setw(8) << "size" << std::setw(12) << "nodes"
+              << std::setw(12) << "parse MB/s" << std::setw(12) << "print MB/s" << std::setw(12) << "ns/node"
+              << std::setw(12) << "allocs" << std::setw(12) << "alloc MB" << std::setw(10) << "B/node" << std::setw(10) << "RSS MB"
+              << std::endl;
+  }
+
+  void PrintResult(const Options &options, std::string_view corpus, const std::string &size, const Measurement &m)
+  {
+    const double parse_mbs = MegabytesPerSecond(m.input_bytes, m.parse_seconds);
+    const double print_mbs = MegabytesPerSecond(m.output_bytes, m.print_seconds);
+    const double ns_per_node = m.parse_seconds * 1e9 / static_cast<double>(m.nodes);
+    const double alloc_mb = static_cast<double>(m.allocated_bytes) / (1 << 20);
+    const double bytes_per_node = static_cast<double>(m.document_bytes) / static_cast<double>(m.nodes);
+    const double rss_mb = static_cast<double>(m.peak_rss_kb) / 1024;
+    if (options.json)
+    {
+      // Результаты печатаются самой библиотекой
+      const Document row(Node{Dict{
+          {"corpus"s, Node{std::string(corpus)}},
+          {"size"s, Node{size}},
+          {"input_bytes"s, Node{uint64_t{m.input_bytes}}},
+          {"nodes"s, Node{uint64_t{m.nodes}}},
+          {"parse_mb_s"s, Node{parse_mbs}},
+          {"print_mb_s"s, Node{print_mbs}},
+          {"ns_per_node"s, Node{ns_per_node}},
+          {"allocations"s, Node{uint64_t{m.allocations}}},
+          {"allocated_bytes"s, Node{uint64_t{m.allocated_bytes}}},
+          {"document_bytes"s, Node{uint64_t{m.document_bytes}}},
+          {"bytes_per_node"s, Node{bytes_per_node}},
+          {"node_size"s, Node{uint64_t{sizeof(Node)}}},
+          {"peak_rss_kb"s, Node{int64_t{m.peak_rss_kb}}},
+          {"skipped_lines"s, Node{uint64_t{m.skipped_lines}}},
+          {"skipped_bytes"s, Node{uint64_t{m.skipped_bytes}}},
+      }});
+      json::Print(row, std::cout);
+      std::cout << std::endl;
+      return;
+    }
+    std::cout << std::left << std::setw(10) << corpus << std::right << std::setw(8) << size << std::setw(12) << m.nodes
+              << std::fixed << std::setprecision(1) << std::setw(12) << parse_mbs << std::setw(12) << print_mbs
+              << std::setw(12) << ns_per_node << std::setw(12) << m.allocations << std::setw(12) << alloc_mb
+              << std::setw(10) << bytes_per_node << std::setw(10) << rss_mb << std::endl;
+    if (m.skipped_lines != 0)
+    {
+      const double skipped_share = static_cast<double>(m.skipped_bytes) / static_cast<double>(m.input_bytes + m.skipped_bytes);
+      std::cout << "  skipped "sv << m.skipped_lines << " lines that failed to parse, "sv << skipped_share * 100
+                << "% of input bytes"sv << std::endl;
+    }
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  const std::optional<Options> options = ParseArguments(argc, argv);
+  if (!options)
+  {
+    PrintUsage(std::cerr);
+    return 2;
+  }
+#ifndef __OPTIMIZE__
+  std::cerr << "warning: the benchmark is built without optimization, configure with -DCMAKE_BUILD_TYPE=Release"sv << std::endl;
+#endif
+
+  try
+  {
+    if (!options->json)
+    {
+      PrintHeader();
+    }
+    if (options->replay)
+    {
+      const std::string &path = *options->replay;
+      const Measurement m = RunIsolated([&path, &options]
+                                        {
+                                          const auto file = MappedFile::Open(path);
+                                          const ReplayLines lines = ParsableLines(file->GetData(), options->skip_invalid);
+                                          Measurement result = MeasureLines(lines.text, options->min_time);
+                                          result.skipped_lines = lines.skipped_lines;
+                                          result.skipped_bytes = lines.skipped_bytes;
+                                          return result; });
+      PrintResult(*options, "replay"sv, FormatSize(m.input_bytes), m);
+      return 0;
+    }
+
+    for (const CorpusKind &kind : kCorpora)
+    {
+      if (!options->corpora.empty() && std::find(options->corpora.begin(), options->corpora.end(), kind.name) == options->corpora.end())
+      {
+        continue;
+      }
+      // Размеры растут в 16 раз: 1K, 16K, 256K, 4M, 64M, 1G
+      for (size_t size = options->min_size; size <= options->max_size; size *= 16)
+      {
+        const Measurement m = RunIsolated([&kind, size, &options]
+                                          {
+                                            const std::string text = GenerateCorpus(kind, size);
+                                            return kind.format == Format::Document ? MeasureDocument(text, options->min_time)
+                                                                                   : MeasureLines(text, options->min_time); });
+        PrintResult(*options, kind.name, FormatSize(size), m);
+      }
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "error: "sv << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
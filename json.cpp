@@ -1,437 +1,691 @@
 #include "json.h"
+#include "json_node_builder.h"
+#include "json_parser.h"
+#include "log_duration.h"
+
+#include <functional>
+#include <iterator>
+#include <limits>
 
 using namespace std;
 
 namespace json
 {
 
-    namespace
+    void ValuePrinter::operator()(std::nullptr_t)
     {
-        using Number = std::variant<int, double>;
-
-        Node LoadNode(istream &input);
-
-        Node LoadArray(istream &input)
+        out.Write("null"sv);
+    }
+    void ValuePrinter::operator()(const Array &array)
+    {
+        out.Put('[');
+        bool is_first = true;
+        for (const auto &node : array)
         {
-            Array result;
-            char c;
-
-            for (; input >> c && c != ']';)
+            if (!is_first)
             {
-                if (c != ',')
-                {
-                    input.putback(c);
-                }
-                result.push_back(LoadNode(input));
+                out.Put(',');
             }
-            if (c != ']')
+            node.Visit(*this);
+            is_first = false;
+        }
+        out.Put(']');
+    }
+    void ValuePrinter::operator()(const Dict &dict)
+    {
+        out.Put('{');
+        bool is_first = true;
+        for (const auto &[key, node] : dict)
+        {
+            if (!is_first)
             {
-                throw ParsingError("Unexpected end if Array");
+                out.Put(',');
             }
-            return Node(move(result));
+            out.WriteString(key);
+            out.Put(':');
+            node.Visit(*this);
+            is_first = false;
         }
+        out.Put('}');
+    }
+    void ValuePrinter::operator()(bool value)
+    {
+        out.Write(value ? "true"sv : "false"sv);
+    }
+    void ValuePrinter::operator()(int value) { out.WriteInt(value); }
+    void ValuePrinter::operator()(int64_t value) { out.WriteInt(value); }
+    void ValuePrinter::operator()(uint64_t value) { out.WriteUint(value); }
+    void ValuePrinter::operator()(double value) { out.WriteDouble(value); }
+    void ValuePrinter::operator()(const std::string &value)
+    {
+        out.WriteString(value);
+    }
+    void ValuePrinter::operator()(std::string_view value)
+    {
+        out.WriteString(value);
+    }
 
-        std::string ParseString(istream &input)
+    // Node::Ctors
+    Node::Node(nullptr_t) noexcept {}
+    Node::Node(Array array) : type_(Type::Array) { payload_.as_array = new Array(move(array)); }
+    Node::Node(Dict map) : type_(Type::Dict) { payload_.as_map = new Dict(move(map)); }
+    Node::Node(bool value) noexcept : type_(Type::Bool) { payload_.as_bool = value; }
+    Node::Node(int value) noexcept : type_(Type::Int) { payload_.as_int = value; }
+    Node::Node(int64_t value) noexcept
+    {
+        if (value >= numeric_limits<int>::min() && value <= numeric_limits<int>::max())
         {
-            string line;
-            while (isalpha(input.peek()))
-            {
-                line.push_back(input.get());
-            }
-            return line;
+            type_ = Type::Int;
+            payload_.as_int = static_cast<int>(value);
+        }
+        else
+        {
+            type_ = Type::Int64;
+            payload_.as_int64 = value;
+        }
+    }
+    Node::Node(uint64_t value) noexcept
+        : Node(static_cast<int64_t>(value))
+    {
+        // Значения вне диапазона int64_t хранятся без преобразования
+        if (value > static_cast<uint64_t>(numeric_limits<int64_t>::max()))
+        {
+            type_ = Type::Uint64;
+            payload_.as_uint64 = value;
+        }
+    }
+    Node::Node(double value) noexcept : type_(Type::Double) { payload_.as_double = value; }
+    Node::Node(string value) : type_(Type::String) { payload_.as_string = new string(move(value)); }
+    Node::Node(std::string_view value) : Node(string(value)) {}
+    Node::Node(const char *value) : Node(string(value)) {}
+
+    Node Node::FromBorrowedString(std::string_view value)
+    {
+        // Длина хранится в 32 битах, более длинные строки копируются
+        if (value.size() > numeric_limits<uint32_t>::max())
+        {
+            return Node(std::string(value));
+        }
+        Node node;
+        node.type_ = Type::BorrowedString;
+        node.payload_.as_chars = value.data();
+        node.borrowed_size_ = static_cast<uint32_t>(value.size());
+        return node;
+    }
+
+    Node::Node(const Node &other)
+        : type_(other.type_), borrowed_size_(other.borrowed_size_)
+    {
+        switch (type_)
+        {
+        case Type::Array:
+            payload_.as_array = new Array(*other.payload_.as_array);
+            break;
+        case Type::Dict:
+            payload_.as_map = new Dict(*other.payload_.as_map);
+            break;
+        case Type::String:
+            payload_.as_string = new string(*other.payload_.as_string);
+            break;
+        case Type::BorrowedString:
+            // Копия не должна зависеть от памяти, на которую ссылается оригинал
+            type_ = Type::String;
+            payload_.as_string = new string(other.payload_.as_chars, other.borrowed_size_);
+            break;
+        default:
+            payload_ = other.payload_;
+        }
+    }
+
+    Node::Node(Node &&other) noexcept
+        : payload_(other.payload_), type_(other.type_), borrowed_size_(other.borrowed_size_)
+    {
+        other.type_ = Type::Null;
+    }
+
+    Node &Node::operator=(const Node &other)
+    {
+        if (this != &other)
+        {
+            *this = Node(other);
+        }
+        return *this;
+    }
+
+    Node &Node::operator=(Node &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            payload_ = other.payload_;
+            type_ = other.type_;
+            borrowed_size_ = other.borrowed_size_;
+            other.type_ = Type::Null;
+        }
+        return *this;
+    }
+
+    Node::~Node()
+    {
+        Reset();
+    }
+
+    void Node::Reset() noexcept
+    {
+        switch (type_)
+        {
+        case Type::Array:
+            delete payload_.as_array;
+            break;
+        case Type::Dict:
+            delete payload_.as_map;
+            break;
+        case Type::String:
+            delete payload_.as_string;
+            break;
+        default:
+            break;
         }
+        type_ = Type::Null;
+    }
 
-        // Считывает содержимое строкового литерала JSON-документа
-        // Функцию следует использовать после считывания открывающего символа ":
-        std::string LoadString(std::istream &input)
+    // Node::Is
+    bool Node::IsNull() const { return type_ == Type::Null; }
+    bool Node::IsArray() const { return type_ == Type::Array; }
+    bool Node::IsMap() const { return type_ == Type::Dict; }
+    bool Node::IsBool() const { return type_ == Type::Bool; }
+    bool Node::IsInt() const { return type_ == Type::Int; }
+    bool Node::IsInt64() const { return type_ == Type::Int || type_ == Type::Int64; }
+    bool Node::IsUint64() const
+    {
+        return type_ == Type::Uint64 || (type_ == Type::Int && payload_.as_int >= 0) || (type_ == Type::Int64 && payload_.as_int64 >= 0);
+    }
+    bool Node::IsPureDouble() const { return type_ == Type::Double; }
+    bool Node::IsDouble() const { return IsPureDouble() || IsInt64() || type_ == Type::Uint64; }
+    bool Node::IsString() const { return type_ == Type::String || type_ == Type::BorrowedString; }
+    bool Node::IsBorrowedString() const { return type_ == Type::BorrowedString; }
+
+    // Node::As
+    const Array &Node::AsArray() const
+    {
+        CheckType(Type::Array);
+        return *payload_.as_array;
+    }
+    const Dict &Node::AsMap() const
+    {
+        CheckType(Type::Dict);
+        return *payload_.as_map;
+    }
+    Array &Node::AsArray()
+    {
+        CheckType(Type::Array);
+        return *payload_.as_array;
+    }
+    Dict &Node::AsMap()
+    {
+        CheckType(Type::Dict);
+        return *payload_.as_map;
+    }
+    bool Node::AsBool() const
+    {
+        CheckType(Type::Bool);
+        return payload_.as_bool;
+    }
+    int Node::AsInt() const
+    {
+        CheckType(Type::Int);
+        return payload_.as_int;
+    }
+    int64_t Node::AsInt64() const
+    {
+        if (IsInt())
+        {
+            return payload_.as_int;
+        }
+        CheckType(Type::Int64);
+        return payload_.as_int64;
+    }
+    uint64_t Node::AsUint64() const
+    {
+        if (!IsUint64())
+        {
+            throw(std::logic_error("value holds different type"));
+        }
+        return type_ == Type::Uint64 ? payload_.as_uint64 : static_cast<uint64_t>(AsInt64());
+    }
+    double Node::AsDouble() const
+    {
+        switch (type_)
         {
-            using namespace std::literals;
+        case Type::Int:
+            return static_cast<double>(payload_.as_int);
+        case Type::Int64:
+            return static_cast<double>(payload_.as_int64);
+        case Type::Uint64:
+            return static_cast<double>(payload_.as_uint64);
+        default:
+            CheckType(Type::Double);
+            return payload_.as_double;
+        }
+    }
+    const std::string &Node::AsString() const
+    {
+        if (IsBorrowedString())
+        {
+            throw(std::logic_error("string is borrowed from the source buffer, use AsStringView"));
+        }
+        CheckType(Type::String);
+        return *payload_.as_string;
+    }
+    std::string_view Node::AsStringView() const
+    {
+        if (IsBorrowedString())
+        {
+            return std::string_view(payload_.as_chars, borrowed_size_);
+        }
+        CheckType(Type::String);
+        return *payload_.as_string;
+    }
 
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true)
+    bool operator==(const Node &lft, const Node &rgt)
+    {
+        return lft.Visit(
+            [&rgt](const auto &lft_value)
             {
-                if (it == end)
+                using T = std::decay_t<decltype(lft_value)>;
+                if constexpr (std::is_same_v<T, std::nullptr_t>)
                 {
-                    // Поток закончился до того, как встретили закрывающую кавычку?
-                    throw ParsingError("String parsing error");
+                    return rgt.IsNull();
                 }
-                const char ch = *it;
-                if (ch == '"')
+                else if constexpr (std::is_same_v<T, Array>)
                 {
-                    // Встретили закрывающую кавычку
-                    ++it;
-                    break;
+                    return rgt.IsArray() && lft_value == rgt.AsArray();
                 }
-                else if (ch == '\\')
+                else if constexpr (std::is_same_v<T, Dict>)
                 {
-                    // Встретили начало escape-последовательности
-                    ++it;
-                    if (it == end)
-                    {
-                        // Поток завершился сразу после символа обратной косой черты
-                        throw ParsingError("String parsing error");
-                    }
-                    const char escaped_char = *(it);
-                    // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-                    switch (escaped_char)
-                    {
-                    case 'n':
-                        s.push_back('\n');
-                        break;
-                    case 't':
-                        s.push_back('\t');
-                        break;
-                    case 'r':
-                        s.push_back('\r');
-                        break;
-                    case '"':
-                        s.push_back('"');
-                        break;
-                    case '\\':
-                        s.push_back('\\');
-                        break;
-                    default:
-                        // Встретили неизвестную escape-последовательность
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-                    }
+                    return rgt.IsMap() && lft_value == rgt.AsMap();
                 }
-                else if (ch == '\n' || ch == '\r')
+                else if constexpr (std::is_same_v<T, bool>)
                 {
-                    // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-                    throw ParsingError("Unexpected end of line"s);
+                    return rgt.IsBool() && lft_value == rgt.AsBool();
                 }
-                else
+                else if constexpr (std::is_same_v<T, int>)
                 {
-                    // Просто считываем очередной символ и помещаем его в результирующую строку
-                    s.push_back(ch);
+                    return rgt.IsInt() && lft_value == rgt.AsInt();
                 }
-                ++it;
-            }
-
-            return s;
-        }
-
-        Node LoadDict(istream &input)
-        {
-            Dict result;
-            char c;
-            for (; input >> c && c != '}';)
-            {
-                if (c == ',')
+                else if constexpr (std::is_same_v<T, int64_t>)
                 {
-                    input >> c;
+                    return rgt.IsInt64() && lft_value == rgt.AsInt64();
                 }
-
-                string key = Node(LoadString(input)).AsString();
-                input >> c;
-                result.insert({move(key), LoadNode(input)});
-            }
-            if (c != '}')
-            {
-                throw ParsingError("Unexpected end of Dict");
-            }
-
-            return Node(move(result));
-        }
-        Number LoadNumber(std::istream &input)
-        {
-            using namespace std::literals;
-
-            std::string parsed_num;
-
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input]
-            {
-                parsed_num += static_cast<char>(input.get());
-                if (!input)
+                else if constexpr (std::is_same_v<T, uint64_t>)
                 {
-                    throw ParsingError("Failed to read number from stream"s);
+                    return rgt.IsUint64() && lft_value == rgt.AsUint64();
                 }
-            };
-
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char]
-            {
-                char peek_ = input.peek();
-                if (!std::isdigit(peek_))
+                else if constexpr (std::is_same_v<T, double>)
                 {
-                    throw ParsingError("A digit is expected"s);
+                    return rgt.IsPureDouble() && lft_value == rgt.AsDouble();
                 }
-                while (std::isdigit(input.peek()))
+                else
                 {
-                    read_char();
+                    // Строки сравниваются по содержимому независимо от того, где они лежат
+                    return rgt.IsString() && std::string_view(lft_value) == rgt.AsStringView();
                 }
-            };
+            });
+    }
+    bool operator!=(const Node &lft, const Node &rgt) { return !(lft == rgt); }
 
-            if (input.peek() == '-')
-            {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0')
+    Document::Document(Node root)
+        : root_(move(root))
+    {
+    }
+
+    Document::Document(Node root, std::shared_ptr<const void> source)
+        : root_(move(root)), source_(move(source))
+    {
+    }
+
+    const Node &Document::GetRoot() const
+    {
+        return root_;
+    }
+
+    Node &Document::GetMutableRoot()
+    {
+        if (source_)
+        {
+            root_ = Node(root_);
+            source_.reset();
+        }
+        return root_;
+    }
+
+    namespace
+    {
+#if !defined(JSON_INTERN_KEYS) && !defined(JSON_FLAT_DICT)
+        // Аллокатор, запоминающий размер последнего выделенного блока
+        template <typename T>
+        struct SizeProbeAllocator
+        {
+            using value_type = T;
+
+            explicit SizeProbeAllocator(size_t *size) noexcept
+                : size(size)
             {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
             }
-            else
+            template <typename U>
+            SizeProbeAllocator(const SizeProbeAllocator<U> &other) noexcept
+                : size(other.size)
             {
-                read_digits();
             }
 
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.')
+            T *allocate(size_t n)
             {
-                read_char();
-                read_digits();
-                is_int = false;
+                *size = n * sizeof(T);
+                return std::allocator<T>().allocate(n);
             }
-
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E')
+            void deallocate(T *ptr, size_t n) noexcept
             {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-')
-                {
-                    read_char();
-                }
-                read_digits();
-                is_int = false;
+                std::allocator<T>().deallocate(ptr, n);
             }
 
-            try
+            template <typename U>
+            bool operator==(const SizeProbeAllocator<U> &other) const noexcept
             {
-                if (is_int)
-                {
-                    // Сначала пробуем преобразовать строку в int
-                    try
-                    {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...)
-                    {
-                        // В случае неудачи, например, при переполнении,
-                        // код ниже попробует преобразовать строку в double
-                    }
-                }
-                return std::stod(parsed_num);
+                return size == other.size;
             }
-            catch (...)
+            template <typename U>
+            bool operator!=(const SizeProbeAllocator<U> &other) const noexcept
             {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+                return size != other.size;
             }
+
+            size_t *size;
+        };
+
+        // Размер блока, который словарь выделяет под один элемент: пара вместе с заголовком
+        // узла дерева. Определяется один раз вставкой в такой же словарь с аллокатором-зондом
+        size_t DictNodeSize()
+        {
+            static const size_t size = [] {
+                size_t result = 0;
+                using Probe = SizeProbeAllocator<Dict::value_type>;
+                std::map<Dict::key_type, Dict::mapped_type, Dict::key_compare, Probe> probe{Probe{&result}};
+                probe.emplace();
+                return result;
+            }();
+            return size;
         }
+#endif
 
-        Node LoadNode(istream &input)
+        // Подсчитывает узлы и память для Document::Stats. Размеры блоков оцениваются по
+        // запрошенному у аллокатора, без служебных данных самого аллокатора
+        struct StatsCollector
         {
-            char c;
-            input >> c;
+            DocumentStats &stats;
 
-            if (c == '[')
-            {
-                return LoadArray(input);
-            }
-            else if (c == '{')
+            void operator()(std::nullptr_t) { ++stats.nulls; }
+            void operator()(bool) { ++stats.bools; }
+            void operator()(int) { ++stats.ints; }
+            void operator()(int64_t) { ++stats.ints; }
+            void operator()(uint64_t) { ++stats.ints; }
+            void operator()(double) { ++stats.doubles; }
+
+            void operator()(const std::string &value)
             {
-                return LoadDict(input);
+                ++stats.strings;
+                AddBlock(sizeof(std::string));
+                AddString(value);
             }
-            else if (c == '"')
+
+            void operator()(std::string_view value)
             {
-                // FROM HERE
-                return Node(LoadString(input));
+                ++stats.borrowed_strings;
+                stats.borrowed_string_bytes += value.size();
             }
-            else if (isalpha(c))
+
+            void operator()(const Array &array)
             {
-                input.putback(c);
-                std::string word = ParseString(input);
-                if (word == "null"sv)
-                {
-                    return Node(nullptr);
-                }
-                else if (word == "true"sv)
+                ++stats.arrays;
+                AddBlock(sizeof(Array));
+                AddItems(array);
+                for (const Node &node : array)
                 {
-                    return Node(true);
+                    node.Visit(*this);
                 }
-                else if (word == "false"sv)
-                {
-                    return Node(false);
-                }
-                else
+            }
+
+            void operator()(const Dict &dict)
+            {
+                ++stats.dicts;
+                AddBlock(sizeof(Dict));
+#if defined(JSON_INTERN_KEYS) || defined(JSON_FLAT_DICT)
+                AddItems(dict);
+#else
+                stats.allocations += dict.size();
+                stats.allocated_bytes += dict.size() * DictNodeSize();
+#endif
+                for (const auto &[key, node] : dict)
                 {
-                    throw ParsingError("Couldn't parse null, true or false");
+                    ++stats.keys;
+                    AddKey(key);
+                    node.Visit(*this);
                 }
             }
-            else if (isdigit(c) || c == '-')
+
+            void AddBlock(size_t size)
             {
-                input.putback(c);
-                auto number = LoadNumber(input);
-                if (std::holds_alternative<int>(number))
+                ++stats.allocations;
+                stats.allocated_bytes += size;
+            }
+
+            // Буфер вектора или словаря-вектора
+            template <typename Items>
+            void AddItems(const Items &items)
+            {
+                if (items.capacity() != 0)
                 {
-                    return Node(get<int>(number));
+                    using Item = typename Items::value_type;
+                    AddBlock(items.capacity() * sizeof(Item));
+                    stats.unused_capacity_bytes += (items.capacity() - items.size()) * sizeof(Item);
                 }
-                else if (std::holds_alternative<double>(number))
+            }
+
+            // Символы строки. Короткие строки хранятся внутри самого объекта std::string
+            void AddString(const std::string &value)
+            {
+                stats.string_bytes += value.size();
+                const std::less<const char *> less;
+                const char *object = reinterpret_cast<const char *>(&value);
+                if (less(value.data(), object) || !less(value.data(), object + sizeof(std::string)))
                 {
-                    return Node(get<double>(number));
+                    AddBlock(value.capacity() + 1);
                 }
-                throw ParsingError("Couldn't recognize number");
             }
-            else
+
+            void AddKey(const std::string &key)
             {
-                throw ParsingError("Couldn't recognize type");
+                AddString(key);
             }
-        }
 
+            void AddKey(const Key &key)
+            {
+                stats.shared_key_bytes += key.GetString().size();
+            }
+        };
     } // namespace
 
-    void ValuePrinter::operator()(std::nullptr_t)
+    DocumentStats Document::Stats() const
     {
-        out << "null"s;
+        DocumentStats stats;
+        root_.Visit(StatsCollector{stats});
+        return stats;
     }
-    void ValuePrinter::operator()(Array array)
+
+    const char *ParseError::Message() const
     {
-        out << "["s;
-        bool is_first = true;
-        for (const auto &node : array)
+        switch (code)
         {
-            if (!is_first)
-            {
-                out << ","s;
-            }
-            visit(ValuePrinter{out}, node.GetValue());
-            is_first = false;
+        case ParseErrorCode::Ok:
+            return "No error";
+        case ParseErrorCode::UnexpectedEnd:
+            return "Unexpected end of input";
+        case ParseErrorCode::TrailingData:
+            return "Unexpected data after the root value";
+        case ParseErrorCode::UnexpectedToken:
+            return "A value is expected";
+        case ParseErrorCode::CommaOrBracketExpected:
+            return "',' or ']' is expected";
+        case ParseErrorCode::KeyExpected:
+            return "A string key is expected";
+        case ParseErrorCode::ColonExpected:
+            return "':' is expected";
+        case ParseErrorCode::CommaOrBraceExpected:
+            return "',' or '}' is expected";
+        case ParseErrorCode::UnterminatedString:
+            return "String parsing error";
+        case ParseErrorCode::InvalidEscape:
+            return "Unrecognized escape sequence";
+        case ParseErrorCode::NewlineInString:
+            return "Unexpected end of line";
+        case ParseErrorCode::InvalidLiteral:
+            return "Couldn't parse null, true or false";
+        case ParseErrorCode::InvalidNumber:
+            return "A digit is expected";
+        case ParseErrorCode::NumberOutOfRange:
+            return "Number is out of range";
+        case ParseErrorCode::UnexpectedCharacter:
+            return "Unexpected character after value";
+        case ParseErrorCode::DepthLimitExceeded:
+            return "Maximum nesting depth is exceeded";
+        case ParseErrorCode::InputTooLarge:
+            return "Input is too large";
         }
-        out << "]"s;
+        return "Unknown error";
     }
-    void ValuePrinter::operator()(Dict dict)
+
+    std::string ParseError::ToString() const
     {
-        out << "{"s;
-        bool is_first = true;
-        for (const auto &[key, node] : dict)
+        return std::string(Message()) + " at line "s + std::to_string(line) + ", column "s + std::to_string(column);
+    }
+
+    struct Loader::Impl
+    {
+        explicit Impl(const ParseOptions &options)
+            : make_key(options.key_table), builder(make_key)
         {
-            if (!is_first)
-            {
-                out << ","s;
-            }
-            out << "\""s << key << "\":"s;
-            visit(ValuePrinter{out}, node.GetValue());
-            is_first = false;
+            context.max_depth = options.max_depth;
         }
-        out << "}"s;
+
+        detail::ParserContext context;
+        detail::KeyMaker make_key;
+        detail::NodeBuilder builder;
+    };
+
+    Loader::Loader()
+        : Loader(ParseOptions{})
+    {
     }
-    void ValuePrinter::operator()(bool value)
+
+    Loader::Loader(const ParseOptions &options)
+        : impl_(make_unique<Impl>(options))
     {
-        out << (value ? "true"s : "false"s);
     }
-    void ValuePrinter::operator()(int value) { out << value; }
-    void ValuePrinter::operator()(double value) { out << value; }
-    void ValuePrinter::operator()(std::string value)
+
+    Loader::Loader(Loader &&) noexcept = default;
+    Loader &Loader::operator=(Loader &&) noexcept = default;
+    Loader::~Loader() = default;
+
+    Result<Document> Loader::TryLoad(std::string_view input)
+    {
+        return TryLoad(input, nullptr);
+    }
+
+    Document Loader::Load(std::string_view input)
     {
-        out << "\""sv;
-        for (char c : value)
+        return TryLoad(input).GetValue();
+    }
+
+    Result<Document> Loader::TryLoad(std::string_view input, std::shared_ptr<const void> source)
+    {
+        LOG_DURATION_STATIC("json::Load");
+        impl_->builder.SetSource(source ? input : std::string_view());
+        if (const auto error = detail::TryParse(input, impl_->builder, impl_->context))
         {
-            if (c == '\\')
-            {
-                out << "\\\\"s;
-            }
-            else if (c == '\"')
-            {
-                out << "\\\""sv;
-            }
-            else if (c == '\r')
-            {
-                out << "\\r"sv;
-            }
-            else if (c == '\n')
-            {
-                out << "\\n"sv;
-            }
-            else if (c == '\t')
-            {
-                out << "\\t"sv;
-            }
-            else
-            {
-                out << c;
-            }
+            // Недостроенные контейнеры не должны попасть в следующий документ
+            impl_->builder = detail::NodeBuilder(impl_->make_key);
+            return *error;
         }
-        out << "\""sv;
+        return Document{impl_->builder.ExtractRoot(), move(source)};
     }
 
-    const Node::Value &Node::GetValue() const
+    Document Loader::Load(std::string_view input, std::shared_ptr<const void> source)
     {
-        return value_;
+        return TryLoad(input, move(source)).GetValue();
     }
 
-    // Node::Ctors
-    Node::Node(nullptr_t) : value_(nullptr) {}
-    Node::Node(Array array) : value_(move(array)) {}
-    Node::Node(Dict map) : value_(move(map)) {}
-    Node::Node(bool value) : value_(value) {}
-    Node::Node(int value) : value_(value) {}
-    Node::Node(double value) : value_(value) {}
-    Node::Node(string value) : value_(move(value)) {}
-
-    // Node::Is
-    bool Node::IsNull() const { return Is<nullptr_t>(); }
-    bool Node::IsArray() const { return Is<Array>(); }
-    bool Node::IsMap() const { return Is<Dict>(); }
-    bool Node::IsBool() const { return Is<bool>(); }
-    bool Node::IsInt() const { return Is<int>(); }
-    bool Node::IsPureDouble() const { return Is<double>(); }
-    bool Node::IsDouble() const { return IsPureDouble() || Is<int>(); }
-    bool Node::IsString() const { return Is<std::string>(); }
+    Document Load(const char *data, size_t size)
+    {
+        return Loader().Load(std::string_view(data, size));
+    }
 
-    // Node::As
-    const Array &Node::AsArray() const { return ExtractValue<Array>(); }
-    const Dict &Node::AsMap() const { return ExtractValue<Dict>(); }
-    bool Node::AsBool() const { return ExtractValue<bool>(); }
-    int Node::AsInt() const { return ExtractValue<int>(); }
-    double Node::AsDouble() const
+    Document Load(std::string_view input)
     {
-        if (Is<int>())
-        {
-            return static_cast<double>(AsInt());
-        }
-        return ExtractValue<double>();
+        return Load(input.data(), input.size());
     }
-    const std::string &Node::AsString() const
+
+    Result<Document> TryLoad(std::string_view input)
     {
-        return ExtractValue<std::string>();
+        return Loader().TryLoad(input);
     }
 
-    bool operator==(const Node &lft, const Node &rgt)
+    Document Load(std::string_view input, std::shared_ptr<const void> source)
     {
-        return lft.IsNull() == rgt.IsNull() &&
-               lft.IsArray() == rgt.IsArray() &&
-               lft.IsMap() == rgt.IsMap() &&
-               lft.IsBool() == rgt.IsBool() &&
-               lft.IsPureDouble() == rgt.IsPureDouble() &&
-               lft.IsInt() == rgt.IsInt() &&
-               lft.IsString() == rgt.IsString() &&
-               lft.GetValue() == rgt.GetValue();
+        return Loader().Load(input, move(source));
     }
-    bool operator!=(const Node &lft, const Node &rgt) { return !(lft == rgt); }
 
-    Document::Document(Node root)
-        : root_(move(root))
+    Result<Document> TryLoad(std::string_view input, std::shared_ptr<const void> source)
     {
+        return Loader().TryLoad(input, move(source));
     }
 
-    const Node &Document::GetRoot() const
+    Document Load(std::shared_ptr<const std::string> input)
     {
-        return root_;
+        const std::string_view text = *input;
+        return Load(text, move(input));
     }
 
     Document Load(istream &input)
     {
-        return Document{LoadNode(input)};
+        // Считываем поток целиком в буфер и разбираем его уже без участия istream
+        const std::string buffer(std::istreambuf_iterator<char>(input), {});
+        return Load(buffer);
     }
 
+    namespace
+    {
+        template <typename Output>
+        void PrintTo(const Document &doc, Output &&output)
+        {
+            LOG_DURATION_STATIC("json::Print");
+            OutputBuffer out(output);
+            doc.GetRoot().Visit(ValuePrinter{out});
+            out.Flush();
+        }
+    } // namespace
+
     void Print(const Document &doc, std::ostream &output)
     {
-        visit(ValuePrinter{output}, doc.GetRoot().GetValue());
+        PrintTo(doc, output);
+    }
+
+    void Print(const Document &doc, std::string &output)
+    {
+        PrintTo(doc, output);
+    }
+
+    void Print(const Document &doc, int fd)
+    {
+        PrintTo(doc, fd);
     }
 
 } // namespace json
\ No newline at end of file
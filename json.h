@@ -1,17 +1,33 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <string_view>
 #include <variant>
+#include <vector>
+
+#include "json_flat_dict.h"
+#include "json_key.h"
+#include "json_output.h"
 
 namespace json
 {
 
     class Node;
     // Сохраните объявления Dict и Array без изменения
+#if defined(JSON_INTERN_KEYS)
+    // Сборка с JSON_INTERN_KEYS хранит пары словаря подряд, а ключи — в общей таблице
+    using Dict = FlatDict<Node, Key>;
+#elif defined(JSON_FLAT_DICT)
+    // Сборка с JSON_FLAT_DICT хранит пары словаря подряд в упорядоченном векторе
+    using Dict = FlatDict<Node>;
+#else
     using Dict = std::map<std::string, Node>;
+#endif
     using Array = std::vector<Node>;
 
     // Эта ошибка должна выбрасываться при ошибках парсинга JSON
@@ -21,89 +37,407 @@ namespace json
         using runtime_error::runtime_error;
     };
 
+    enum class ParseErrorCode
+    {
+        Ok,
+        UnexpectedEnd,
+        TrailingData,
+        UnexpectedToken,
+        CommaOrBracketExpected,
+        KeyExpected,
+        ColonExpected,
+        CommaOrBraceExpected,
+        UnterminatedString,
+        InvalidEscape,
+        NewlineInString,
+        InvalidLiteral,
+        InvalidNumber,
+        NumberOutOfRange,
+        UnexpectedCharacter,
+        DepthLimitExceeded,
+        // Вход длиннее, чем позволяет представление документа (LazyDocument: 4 ГиБ)
+        InputTooLarge,
+    };
+
+    // Описание ошибки разбора. Смещение отсчитывается от начала входа с нуля,
+    // строка и столбец, в которых находится ошибочный символ, — с единицы
+    struct ParseError
+    {
+        ParseErrorCode code = ParseErrorCode::Ok;
+        size_t offset = 0;
+        size_t line = 0;
+        size_t column = 0;
+
+        const char *Message() const;
+        // Сообщение вместе с позицией ошибки
+        std::string ToString() const;
+    };
+
+    // Либо значение, либо ошибка разбора
+    template <typename T>
+    class Result
+    {
+    public:
+        Result(T value)
+            : value_(std::move(value))
+        {
+        }
+
+        Result(ParseError error)
+            : value_(std::move(error))
+        {
+        }
+
+        bool HasValue() const
+        {
+            return value_.index() == 0;
+        }
+
+        explicit operator bool() const
+        {
+            return HasValue();
+        }
+
+        // При отсутствии значения выбрасывает ParsingError
+        T &GetValue() &
+        {
+            CheckValue();
+            return std::get<0>(value_);
+        }
+
+        const T &GetValue() const &
+        {
+            CheckValue();
+            return std::get<0>(value_);
+        }
+
+        T &&GetValue() &&
+        {
+            CheckValue();
+            return std::get<0>(std::move(value_));
+        }
+
+        // При наличии значения выбрасывает std::logic_error
+        const ParseError &GetError() const
+        {
+            if (HasValue())
+            {
+                throw std::logic_error("result holds a value");
+            }
+            return std::get<1>(value_);
+        }
+
+    private:
+        void CheckValue() const
+        {
+            if (!HasValue())
+            {
+                throw ParsingError(std::get<1>(value_).ToString());
+            }
+        }
+
+        std::variant<T, ParseError> value_;
+    };
+
+    // Обходит значения узлов по константным ссылкам и пишет их в буфер вывода
     struct ValuePrinter
     {
-        std::ostream &out;
+        OutputBuffer &out;
         void operator()(std::nullptr_t);
-        void operator()(Array);
-        void operator()(Dict);
+        void operator()(const Array &);
+        void operator()(const Dict &);
         void operator()(bool);
         void operator()(int);
+        void operator()(int64_t);
+        void operator()(uint64_t);
         void operator()(double);
-        void operator()(std::string);
+        void operator()(const std::string &);
+        void operator()(std::string_view);
     };
 
+    // Узел занимает 16 байт: значение скалярного типа хранится внутри узла,
+    // а массив, словарь и строка размещаются в куче, и узел хранит лишь указатель на них
     class Node
     {
     public:
-        using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
-        const Value &GetValue() const;
-
-        Node() = default;
-        Node(nullptr_t);
+        Node() noexcept = default;
+        Node(std::nullptr_t) noexcept;
         Node(Array);
         Node(Dict);
-        Node(bool);
-        Node(int);
-        Node(double);
+        Node(bool) noexcept;
+        Node(int) noexcept;
+        // Целые числа хранятся в самом узком из типов int, int64_t и uint64_t, вмещающем значение,
+        // поэтому Node(int64_t{5}) == Node(5)
+        Node(int64_t) noexcept;
+        Node(uint64_t) noexcept;
+        Node(double) noexcept;
         Node(std::string);
+        // Без этих перегрузок строковый литерал превратился бы в bool
+        Node(std::string_view);
+        Node(const char *);
+
+        // Строковый узел, ссылающийся на чужую память без копирования. Память должна
+        // оставаться неизменной, пока жив узел. Копия узла владеет копией строки
+        static Node FromBorrowedString(std::string_view value);
+
+        // Копирование превращает строки, ссылающиеся на чужую память, в собственные,
+        // поэтому копия не зависит от буфера, на который ссылается оригинал
+
+        Node(const Node &other);
+        Node(Node &&other) noexcept;
+        Node &operator=(const Node &other);
+        Node &operator=(Node &&other) noexcept;
+        ~Node();
 
         bool IsNull() const;
         bool IsArray() const;
         bool IsMap() const;
         bool IsBool() const;
         bool IsInt() const;
+        // Истина для целых чисел, представимых в int64_t (в том числе в int)
+        bool IsInt64() const;
+        // Истина для неотрицательных целых чисел, представимых в uint64_t
+        bool IsUint64() const;
         bool IsPureDouble() const;
         bool IsDouble() const;
         bool IsString() const;
+        // Истина для строки, ссылающейся на чужую память
+        bool IsBorrowedString() const;
 
         const Array &AsArray() const;
         const Dict &AsMap() const;
+        // Изменяемые массив и словарь. Адрес контейнера не меняется при перемещении узла
+        Array &AsArray();
+        Dict &AsMap();
         bool AsBool() const;
         int AsInt() const;
+        int64_t AsInt64() const;
+        uint64_t AsUint64() const;
         double AsDouble() const;
+        // Только для собственных строк. Для строки, ссылающейся на чужую память, объекта
+        // std::string нет, и метод выбрасывает std::logic_error
         const std::string &AsString() const;
+        // Годится для строк обоих видов
+        std::string_view AsStringView() const;
 
-    private:
-        template <typename T>
-        bool Is() const
+        // Создаёт элемент в конце массива прямо на месте, без временного узла
+        template <typename... Args>
+        Node &EmplaceBack(Args &&...args)
+        {
+            return AsArray().emplace_back(std::forward<Args>(args)...);
+        }
+
+        // Создаёт значение ключа key в словаре прямо на месте. Как и std::map::try_emplace,
+        // не меняет значение существующего ключа. Возвращает значение ключа
+        template <typename... Args>
+        Node &Emplace(std::string_view key, Args &&...args)
+        {
+            return AsMap().try_emplace(Dict::key_type(key), std::forward<Args>(args)...).first->second;
+        }
+
+        // Вызывает visitor от хранимого значения: nullptr, const Array&, const Dict&,
+        // bool, int, int64_t, uint64_t, double, const std::string& или std::string_view
+        // (для строки, ссылающейся на чужую память).
+        // int64_t передаётся только для чисел вне диапазона int, uint64_t — вне диапазона int64_t
+        template <typename Visitor>
+        decltype(auto) Visit(Visitor &&visitor) const
         {
-            return std::holds_alternative<T>(value_);
+            switch (type_)
+            {
+            case Type::Array:
+                return visitor(*payload_.as_array);
+            case Type::Dict:
+                return visitor(*payload_.as_map);
+            case Type::Bool:
+                return visitor(payload_.as_bool);
+            case Type::Int:
+                return visitor(payload_.as_int);
+            case Type::Int64:
+                return visitor(payload_.as_int64);
+            case Type::Uint64:
+                return visitor(payload_.as_uint64);
+            case Type::Double:
+                return visitor(payload_.as_double);
+            case Type::String:
+                return visitor(*payload_.as_string);
+            case Type::BorrowedString:
+                return visitor(std::string_view(payload_.as_chars, borrowed_size_));
+            default:
+                return visitor(nullptr);
+            }
         }
 
-        template <typename T>
-        const T &ExtractValue() const
+    private:
+        enum class Type : uint8_t
         {
-            if (!Is<T>())
+            Null,
+            Array,
+            Dict,
+            Bool,
+            Int,
+            Int64,
+            Uint64,
+            Double,
+            String,
+            BorrowedString,
+        };
+
+        union Payload
+        {
+            bool as_bool;
+            int as_int;
+            int64_t as_int64;
+            uint64_t as_uint64;
+            double as_double;
+            Array *as_array;
+            Dict *as_map;
+            std::string *as_string;
+            const char *as_chars;
+        };
+
+        void CheckType(Type type) const
+        {
+            if (type_ != type)
             {
                 throw(std::logic_error("value holds different type"));
             }
-            return std::get<T>(value_);
         }
 
-        Value value_;
-        Array as_array_;
-        Dict as_map_;
-        int as_int_ = 0;
-        std::string as_string_;
+        void Reset() noexcept;
+
+        Payload payload_{};
+        Type type_ = Type::Null;
+        // Длина строки типа BorrowedString. Занимает место, которое иначе ушло бы на выравнивание
+        uint32_t borrowed_size_ = 0;
     };
 
+    static_assert(sizeof(Node) <= 16);
+
     bool operator==(const Node &lft, const Node &rgt);
     bool operator!=(const Node &lft, const Node &rgt);
 
+    // Расход памяти документом. Размеры блоков в куче вычисляются по ёмкости контейнеров
+    // и строк и не учитывают служебные байты самого распределителя (в glibc — от 8 байт на блок
+    // с округлением размера до 16), поэтому реальный расход больше примерно на allocations * 16
+    struct DocumentStats
+    {
+        // Число узлов каждого типа. Целые числа всех трёх размеров учитываются в ints
+        size_t nulls = 0;
+        size_t bools = 0;
+        size_t ints = 0;
+        size_t doubles = 0;
+        size_t strings = 0;
+        // Строки, ссылающиеся на исходный буфер документа
+        size_t borrowed_strings = 0;
+        size_t arrays = 0;
+        size_t dicts = 0;
+        size_t keys = 0;
+
+        // Блоки в куче, принадлежащие документу, и их суммарный размер. Это оценка по размерам,
+        // запрошенным у аллокатора: служебные данные и выравнивание кучи в неё не входят
+        size_t allocations = 0;
+        size_t allocated_bytes = 0;
+        // Символы строк и ключей, лежащие в allocated_bytes
+        size_t string_bytes = 0;
+        // Символы строк, лежащие в исходном буфере
+        size_t borrowed_string_bytes = 0;
+        // Символы ключей из общей таблицы KeyTable (сборка с JSON_INTERN_KEYS). Они не входят
+        // в allocated_bytes, так как принадлежат таблице, а не документу
+        size_t shared_key_bytes = 0;
+        // Занятая, но не используемая ёмкость массивов и словарей-векторов. Входит в allocated_bytes
+        size_t unused_capacity_bytes = 0;
+
+        size_t Nodes() const
+        {
+            return nulls + bools + ints + doubles + strings + borrowed_strings + arrays + dicts;
+        }
+
+        // Всё, что в allocated_bytes не является символами строк: узлы, заголовки контейнеров,
+        // неиспользуемая ёмкость и узлы дерева std::map
+        size_t OverheadBytes() const
+        {
+            return allocated_bytes - string_bytes;
+        }
+    };
+
     class Document
     {
     public:
         explicit Document(Node root);
+        // Документ, строки которого ссылаются на буфер, принадлежащий source.
+        // Документ и все его копии продлевают жизнь source. Узлы, скопированные
+        // из документа, владеют своими строками и от source не зависят
+        Document(Node root, std::shared_ptr<const void> source);
 
         const Node &GetRoot() const;
+        // Изменяемый корень. Узлы из него можно перемещать за пределы документа,
+        // поэтому строки, ссылающиеся на source, сначала копируются в узлы, а source освобождается
+        Node &GetMutableRoot();
+
+        // Обходит дерево и подсчитывает узлы и занятую ими память
+        DocumentStats Stats() const;
 
     private:
         Node root_;
+        std::shared_ptr<const void> source_;
+    };
+
+    struct ParseOptions
+    {
+        static constexpr size_t kDefaultMaxDepth = 512;
+
+        // Наибольшая вложенность массивов и словарей. Документ глубже не разбирается,
+        // что ограничивает и глубину рекурсии при обходе, печати и удалении разобранного дерева.
+        // Деревья, собранные Builder или изменённые через неконстантные методы Node, не
+        // проверяются и могут быть глубже
+        size_t max_depth = kDefaultMaxDepth;
+        // Таблица ключей словарей в сборке с JSON_INTERN_KEYS. Если она не задана, Loader и PushParser
+        // заводят собственную таблицу, которую разделяют только их документы. Чтобы ключи всех
+        // документов были общими, передайте KeyTable::Shared()
+        std::shared_ptr<KeyTable> key_table = nullptr;
+    };
+
+    // Разбирает документы, переиспользуя внутренние буферы разбора между вызовами.
+    // Подходит для разбора множества небольших документов подряд
+    class Loader
+    {
+    public:
+        Loader();
+        explicit Loader(const ParseOptions &options);
+        Loader(Loader &&) noexcept;
+        Loader &operator=(Loader &&) noexcept;
+        ~Loader();
+
+        Document Load(std::string_view input);
+        // Не выбрасывает исключений при ошибках разбора
+        Result<Document> TryLoad(std::string_view input);
+        // Разбирает input, который принадлежит source. Строки без escape-последовательностей
+        // не копируются, а ссылаются на input, поэтому input не должен меняться, пока жив документ.
+        // Такие строки читаются через Node::AsStringView
+        Document Load(std::string_view input, std::shared_ptr<const void> source);
+        Result<Document> TryLoad(std::string_view input, std::shared_ptr<const void> source);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
     };
 
+    // Разбирает документ из непрерывного буфера
+    Document Load(const char *data, size_t size);
+    Document Load(std::string_view input);
+    // Разбирает документ, сообщая об ошибке разбора через результат, а не исключением
+    Result<Document> TryLoad(std::string_view input);
+    // Разбирает документ, не копируя строки без escape-последовательностей (см. Loader::Load)
+    Document Load(std::string_view input, std::shared_ptr<const void> source);
+    Result<Document> TryLoad(std::string_view input, std::shared_ptr<const void> source);
+    Document Load(std::shared_ptr<const std::string> input);
+    // Считывает поток целиком в буфер и разбирает его
     Document Load(std::istream &input);
 
     void Print(const Document &doc, std::ostream &output);
+    // Дописывает документ в конец строки
+    void Print(const Document &doc, std::string &output);
+    // Пишет документ в файловый дескриптор. При ошибке записи выбрасывает std::system_error
+    void Print(const Document &doc, int fd);
 
 } // namespace json
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "json_builder.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace json
+{
+
+    Node &Builder::PrepareSlot()
+    {
+        if (stack_.empty())
+        {
+            if (has_root_)
+            {
+                throw std::logic_error("the root value is already built");
+            }
+            has_root_ = true;
+            return root_;
+        }
+        const Frame &frame = stack_.back();
+        if (frame.array != nullptr)
+        {
+            return frame.array->emplace_back();
+        }
+        if (value_slot_ == nullptr)
+        {
+            throw std::logic_error("a key is expected before a dict value");
+        }
+        return *std::exchange(value_slot_, nullptr);
+    }
+
+    Builder &Builder::Value(Node value)
+    {
+        PrepareSlot() = std::move(value);
+        return *this;
+    }
+
+    Builder &Builder::StartArray()
+    {
+        Node &slot = PrepareSlot();
+        slot = Node(Array());
+        stack_.push_back({&slot.AsArray(), nullptr});
+        return *this;
+    }
+
+    Builder &Builder::EndArray()
+    {
+        if (stack_.empty() || stack_.back().array == nullptr)
+        {
+            throw std::logic_error("no array to end");
+        }
+        stack_.pop_back();
+        return *this;
+    }
+
+    Builder &Builder::StartDict()
+    {
+        Node &slot = PrepareSlot();
+        slot = Node(Dict());
+        stack_.push_back({nullptr, &slot.AsMap()});
+        return *this;
+    }
+
+    Builder &Builder::Key(std::string_view key)
+    {
+        if (stack_.empty() || stack_.back().dict == nullptr)
+        {
+            throw std::logic_error("a key outside of a dict");
+        }
+        if (value_slot_ != nullptr)
+        {
+            throw std::logic_error("a value is expected after a key");
+        }
+        value_slot_ = &stack_.back().dict->try_emplace(Dict::key_type(key)).first->second;
+        return *this;
+    }
+
+    Builder &Builder::EndDict()
+    {
+        if (stack_.empty() || stack_.back().dict == nullptr)
+        {
+            throw std::logic_error("no dict to end");
+        }
+        if (value_slot_ != nullptr)
+        {
+            throw std::logic_error("a value is expected after a key");
+        }
+        stack_.pop_back();
+        return *this;
+    }
+
+    Node Builder::Build()
+    {
+        if (!has_root_ || !stack_.empty())
+        {
+            throw std::logic_error("the document is incomplete");
+        }
+        has_root_ = false;
+        return std::move(root_);
+    }
+
+} // namespace json
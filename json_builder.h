@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+
+namespace json
+{
+
+    // Строит дерево Node последовательными вызовами:
+    //   json::Builder().StartDict().Key("a").Value(1).EndDict().Build()
+    // Каждое значение сразу помещается на своё место в родительском контейнере, поэтому
+    // поддеревья не копируются, а строки и контейнеры, переданные в Value по rvalue, перемещаются.
+    // Вызов, нарушающий структуру документа, выбрасывает std::logic_error
+    class Builder
+    {
+    public:
+        // Значение корня, элемент массива или значение ключа, заданного Key
+        Builder &Value(Node value);
+        Builder &Value(const char *value)
+        {
+            return Value(Node(std::string(value)));
+        }
+        Builder &Value(std::nullptr_t)
+        {
+            return Value(Node());
+        }
+
+        Builder &StartArray();
+        Builder &EndArray();
+
+        Builder &StartDict();
+        // Ключ следующего значения словаря. Значение существующего ключа заменяется
+        Builder &Key(std::string_view key);
+        Builder &EndDict();
+
+        // Возвращает построенный корень. Все контейнеры должны быть закрыты
+        Node Build();
+
+    private:
+        // Место, куда попадёт очередное значение
+        Node &PrepareSlot();
+
+        Node root_;
+        bool has_root_ = false;
+        // Незакрытые контейнеры. Хранятся адреса самих контейнеров, а не узлов:
+        // узел перемещается при росте родителя, а контейнер остаётся на месте
+        struct Frame
+        {
+            Array *array = nullptr;
+            Dict *dict = nullptr;
+        };
+        std::vector<Frame> stack_;
+        // Значение ключа, заданного последним вызовом Key
+        Node *value_slot_ = nullptr;
+    };
+
+} // namespace json
@@ -0,0 +1,178 @@
+#include "json_file.h"
+#include "log_duration.h"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace json
+{
+
+    namespace
+    {
+        [[noreturn]] void ThrowSystemError(const std::string &what, const std::string &path)
+        {
+            const int error = errno;
+            throw std::system_error(error, std::generic_category(), what + " "s + path);
+        }
+
+        // Закрывает дескриптор при выходе из области видимости
+        class FileDescriptor
+        {
+        public:
+            explicit FileDescriptor(int fd)
+                : fd_(fd)
+            {
+            }
+
+            FileDescriptor(const FileDescriptor &) = delete;
+            FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+            ~FileDescriptor()
+            {
+                ::close(fd_);
+            }
+
+            int Get() const
+            {
+                return fd_;
+            }
+
+        private:
+            int fd_;
+        };
+
+        // Считывает всё, что осталось в дескрипторе. Возвращает false при ошибке чтения
+        bool ReadAll(int fd, std::string &buffer)
+        {
+            constexpr size_t kChunkSize = 1 << 16;
+            size_t size = 0;
+            while (true)
+            {
+                if (buffer.size() - size < kChunkSize)
+                {
+                    buffer.resize(size + kChunkSize);
+                }
+                const ssize_t read = ::read(fd, buffer.data() + size, buffer.size() - size);
+                if (read < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                if (read == 0)
+                {
+                    buffer.resize(size);
+                    return true;
+                }
+                size += static_cast<size_t>(read);
+            }
+        }
+    } // namespace
+
+    std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &path)
+    {
+        return Create(path, true);
+    }
+
+    std::shared_ptr<const MappedFile> MappedFile::TryMap(const std::string &path)
+    {
+        return Create(path, false);
+    }
+
+    std::shared_ptr<const MappedFile> MappedFile::Create(const std::string &path, bool allow_read)
+    {
+        const FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        if (fd.Get() < 0)
+        {
+            ThrowSystemError("Failed to open", path);
+        }
+        struct stat info;
+        if (::fstat(fd.Get(), &info) != 0)
+        {
+            ThrowSystemError("Failed to stat", path);
+        }
+
+        std::shared_ptr<MappedFile> file(new MappedFile());
+        const bool is_regular = S_ISREG(info.st_mode);
+        if (is_regular && info.st_size == 0)
+        {
+            // Пустой файл отобразить нельзя, а читать из него нечего
+            file->data_ = file->buffer_;
+            return file;
+        }
+        if (is_regular)
+        {
+            const size_t size = static_cast<size_t>(info.st_size);
+            void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.Get(), 0);
+            if (mapping != MAP_FAILED)
+            {
+                // Файл читается от начала к концу: ядро заранее подгружает следующие страницы
+                // и раньше вытесняет прочитанные. Это только подсказка, поэтому ошибка не важна
+                ::madvise(mapping, size, MADV_SEQUENTIAL);
+                file->mapping_ = mapping;
+                file->mapping_size_ = size;
+                file->data_ = std::string_view(static_cast<const char *>(mapping), size);
+                return file;
+            }
+        }
+        if (!allow_read)
+        {
+            return nullptr;
+        }
+        if (!ReadAll(fd.Get(), file->buffer_))
+        {
+            ThrowSystemError("Failed to read", path);
+        }
+        file->data_ = file->buffer_;
+        return file;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mapping_ != nullptr)
+        {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+
+    Document LoadFile(const std::string &path)
+    {
+        LOG_DURATION_STATIC("json::LoadFile");
+        const std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+        return Load(file->GetData());
+    }
+
+    Result<Document> TryLoadFile(const std::string &path)
+    {
+        LOG_DURATION_STATIC("json::LoadFile");
+        const std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+        return TryLoad(file->GetData());
+    }
+
+    Document LoadMappedFile(const std::string &path)
+    {
+        LOG_DURATION_STATIC("json::LoadMappedFile");
+        std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+        const std::string_view data = file->GetData();
+        return Load(data, std::move(file));
+    }
+
+    Result<Document> TryLoadMappedFile(const std::string &path)
+    {
+        LOG_DURATION_STATIC("json::LoadMappedFile");
+        std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+        const std::string_view data = file->GetData();
+        return TryLoad(data, std::move(file));
+    }
+
+} // namespace json
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "json.h"
+
+namespace json
+{
+
+    // Содержимое файла, доступное только для чтения. Обычный файл отображается в память
+    // целиком, и страницы подгружаются ядром по мере обращения к ним, поэтому файл может
+    // быть больше оперативной памяти. Каналы, устройства и другие файлы, которые нельзя
+    // отобразить, считываются в буфер вызовами read()
+    class MappedFile
+    {
+    public:
+        // Открывает файл и отображает его в память, при невозможности — считывает целиком.
+        // Если файл открыть или прочитать не удалось, выбрасывает std::system_error
+        static std::shared_ptr<const MappedFile> Open(const std::string &path);
+        // То же, но для файла, который нельзя отобразить, возвращает nullptr, ничего из него не читая
+        static std::shared_ptr<const MappedFile> TryMap(const std::string &path);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        std::string_view GetData() const
+        {
+            return data_;
+        }
+
+        // Истина, если данные отображены в память, а не прочитаны в буфер
+        bool IsMapped() const
+        {
+            return mapping_ != nullptr;
+        }
+
+    private:
+        MappedFile() = default;
+
+        static std::shared_ptr<const MappedFile> Create(const std::string &path, bool allow_read);
+
+        void *mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        std::string buffer_;
+        std::string_view data_;
+    };
+
+    // Разбирает файл, отображённый в память, без промежуточного копирования входа в буфер.
+    // Строки документа принадлежат узлам, и отображение закрывается сразу после разбора.
+    // Ошибка открытия или чтения выбрасывается как std::system_error, ошибка разбора — как ParsingError
+    Document LoadFile(const std::string &path);
+    // Не выбрасывает исключений при ошибках разбора
+    Result<Document> TryLoadFile(const std::string &path);
+
+    // То же, но строки без escape-последовательностей не копируются, а ссылаются на отображение
+    // (см. Node::IsBorrowedString), которое остаётся открытым, пока жив документ. Такие строки
+    // читаются через Node::AsStringView
+    Document LoadMappedFile(const std::string &path);
+    Result<Document> TryLoadMappedFile(const std::string &path);
+
+} // namespace json
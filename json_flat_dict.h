@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace json
+{
+
+    // Словарь со строковыми ключами, хранящий пары в одном векторе, упорядоченном по ключу.
+    // Порядок обхода, поиск и сравнение такие же, как у std::map<std::string, Value>,
+    // но все пары лежат в памяти подряд, а не в отдельных узлах дерева. В небольших словарях
+    // ключ ищется линейным просмотром, в больших — двоичным поиском.
+    // Вставка в середину сдвигает последующие пары, поэтому словарь из готового набора
+    // пар лучше строить конструктором от диапазона.
+    // KeyType — std::string или другой тип, приводимый к std::string_view и упорядоченный как строка
+    template <typename Value, typename KeyType = std::string>
+    class FlatDict
+    {
+        // Пары хранятся с изменяемым ключом, чтобы вектор мог их перемещать при вставке и удалении
+        using Item = std::pair<KeyType, Value>;
+        using Items = std::vector<Item>;
+
+        // Пара, выдаваемая итератором: ссылки на ключ и значение хранимой пары. Как и у std::map,
+        // значение можно менять, а ключ — нет. MappedType — Value или const Value
+        template <typename MappedType>
+        struct ItemRef
+        {
+            const KeyType &first;
+            MappedType &second;
+
+            operator std::pair<const KeyType, Value>() const
+            {
+                return {first, second};
+            }
+
+            friend bool operator==(const ItemRef &lhs, const ItemRef &rhs)
+            {
+                return lhs.first == rhs.first && lhs.second == rhs.second;
+            }
+            friend bool operator!=(const ItemRef &lhs, const ItemRef &rhs)
+            {
+                return !(lhs == rhs);
+            }
+            friend bool operator<(const ItemRef &lhs, const ItemRef &rhs)
+            {
+                return lhs.first < rhs.first || (!(rhs.first < lhs.first) && lhs.second < rhs.second);
+            }
+        };
+
+        // Итератор по items_, выдающий ItemRef. Как и std::vector<bool>::iterator, он
+        // произвольного доступа, но разыменовывается во временный объект, а не в ссылку
+        template <bool IsConst>
+        class Iterator
+        {
+            using Base = std::conditional_t<IsConst, typename Items::const_iterator, typename Items::iterator>;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::pair<const KeyType, Value>;
+            using difference_type = std::ptrdiff_t;
+            using reference = ItemRef<std::conditional_t<IsConst, const Value, Value>>;
+            // Результат operator->: хранит ItemRef, к полям которого обращается it->first
+            struct pointer
+            {
+                reference item;
+
+                const reference *operator->() const { return &item; }
+            };
+
+            Iterator() = default;
+            explicit Iterator(Base base)
+                : base_(base)
+            {
+            }
+            // iterator приводится к const_iterator
+            template <bool OtherConst, std::enable_if_t<IsConst && !OtherConst, int> = 0>
+            Iterator(const Iterator<OtherConst> &other)
+                : base_(other.GetBase())
+            {
+            }
+
+            const Base &GetBase() const { return base_; }
+
+            reference operator*() const { return reference{base_->first, base_->second}; }
+            pointer operator->() const { return pointer{**this}; }
+            reference operator[](difference_type n) const { return *(*this + n); }
+
+            Iterator &operator++()
+            {
+                ++base_;
+                return *this;
+            }
+            Iterator operator++(int) { return Iterator(base_++); }
+            Iterator &operator--()
+            {
+                --base_;
+                return *this;
+            }
+            Iterator operator--(int) { return Iterator(base_--); }
+            Iterator &operator+=(difference_type n)
+            {
+                base_ += n;
+                return *this;
+            }
+            Iterator &operator-=(difference_type n)
+            {
+                base_ -= n;
+                return *this;
+            }
+
+            friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+            friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+            friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+            friend difference_type operator-(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ - rhs.base_; }
+
+            friend bool operator==(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ == rhs.base_; }
+            friend bool operator!=(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ != rhs.base_; }
+            friend bool operator<(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ < rhs.base_; }
+            friend bool operator>(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ > rhs.base_; }
+            friend bool operator<=(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ <= rhs.base_; }
+            friend bool operator>=(const Iterator &lhs, const Iterator &rhs) { return lhs.base_ >= rhs.base_; }
+
+        private:
+            Base base_;
+        };
+
+    public:
+        using key_type = KeyType;
+        using mapped_type = Value;
+        using value_type = std::pair<const KeyType, Value>;
+        using size_type = size_t;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        // До такого размера ключ ищется линейным просмотром
+        static constexpr size_t kLinearScanLimit = 16;
+
+        FlatDict() = default;
+
+        FlatDict(std::initializer_list<value_type> items)
+            : FlatDict(items.begin(), items.end())
+        {
+        }
+
+        // Из пар с одинаковыми ключами, как и при вставке в std::map, остаётся первая
+        template <typename InputIt>
+        FlatDict(InputIt first, InputIt last)
+            : items_(first, last)
+        {
+            std::stable_sort(items_.begin(), items_.end(), [](const Item &lhs, const Item &rhs)
+                             { return lhs.first < rhs.first; });
+            items_.erase(std::unique(items_.begin(), items_.end(), [](const Item &lhs, const Item &rhs)
+                                     { return lhs.first == rhs.first; }),
+                         items_.end());
+        }
+
+        iterator begin() { return iterator(items_.begin()); }
+        iterator end() { return iterator(items_.end()); }
+        const_iterator begin() const { return const_iterator(items_.begin()); }
+        const_iterator end() const { return const_iterator(items_.end()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return items_.size(); }
+        bool empty() const { return items_.empty(); }
+        void clear() { items_.clear(); }
+        size_t capacity() const { return items_.capacity(); }
+        void reserve(size_t size) { items_.reserve(size); }
+
+        iterator find(std::string_view key)
+        {
+            return iterator(Find(items_, key));
+        }
+
+        const_iterator find(std::string_view key) const
+        {
+            return const_iterator(Find(items_, key));
+        }
+
+        size_t count(std::string_view key) const
+        {
+            return find(key) != end() ? 1 : 0;
+        }
+
+        Value &at(std::string_view key)
+        {
+            return At(items_, key);
+        }
+
+        const Value &at(std::string_view key) const
+        {
+            return At(items_, key);
+        }
+
+        Value &operator[](std::string_view key)
+        {
+            return try_emplace(KeyType(key)).first->second;
+        }
+
+        // Как и у std::map, не заменяет значение существующего ключа
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(KeyType key, Args &&...args)
+        {
+            const auto it = LowerBound(items_, key);
+            if (it != items_.end() && it->first == key)
+            {
+                return {iterator(it), false};
+            }
+            return {iterator(items_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                            std::forward_as_tuple(std::forward<Args>(args)...))),
+                    true};
+        }
+
+        template <typename K, typename... Args>
+        std::pair<iterator, bool> emplace(K &&key, Args &&...args)
+        {
+            return try_emplace(KeyType(std::forward<K>(key)), std::forward<Args>(args)...);
+        }
+
+        // Вставка в конец по подсказке end() не требует поиска, если ключи идут по возрастанию
+        template <typename K, typename... Args>
+        iterator emplace_hint(const_iterator hint, K &&key, Args &&...args)
+        {
+            KeyType owned_key(std::forward<K>(key));
+            if (hint == cend() && (items_.empty() || items_.back().first < owned_key))
+            {
+                items_.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(owned_key)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+                return std::prev(end());
+            }
+            return try_emplace(std::move(owned_key), std::forward<Args>(args)...).first;
+        }
+
+        std::pair<iterator, bool> insert(value_type item)
+        {
+            return try_emplace(item.first, std::move(item.second));
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return iterator(items_.erase(pos.GetBase()));
+        }
+
+        size_t erase(std::string_view key)
+        {
+            const auto it = Find(items_, key);
+            if (it == items_.end())
+            {
+                return 0;
+            }
+            items_.erase(it);
+            return 1;
+        }
+
+        friend bool operator==(const FlatDict &lhs, const FlatDict &rhs)
+        {
+            return lhs.items_ == rhs.items_;
+        }
+
+        friend bool operator!=(const FlatDict &lhs, const FlatDict &rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        // Первая пара с ключом не меньше key. Items — константный или неконстантный items_
+        template <typename Items>
+        static auto LowerBound(Items &items, std::string_view key)
+        {
+            if (items.size() <= kLinearScanLimit)
+            {
+                return std::find_if(items.begin(), items.end(), [key](const Item &item)
+                                    { return std::string_view(item.first) >= key; });
+            }
+            return std::lower_bound(items.begin(), items.end(), key, [](const Item &item, std::string_view key)
+                                    { return std::string_view(item.first) < key; });
+        }
+
+        template <typename Items>
+        static auto Find(Items &items, std::string_view key)
+        {
+            const auto it = LowerBound(items, key);
+            return it != items.end() && std::string_view(it->first) == key ? it : items.end();
+        }
+
+        template <typename Items>
+        static auto &At(Items &items, std::string_view key)
+        {
+            const auto it = Find(items, key);
+            if (it == items.end())
+            {
+                throw std::out_of_range("FlatDict::at");
+            }
+            return it->second;
+        }
+
+        Items items_;
+    };
+
+} // namespace json
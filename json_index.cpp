@@ -0,0 +1,423 @@
+#include "json_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define JSON_INDEX_X86 1
+#include <immintrin.h>
+#endif
+
+namespace json::detail
+{
+
+    namespace
+    {
+        // Битовые маски блока из 64 символов: i-й бит соответствует i-му символу
+        struct BlockMasks
+        {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t space = 0;
+            uint64_t op = 0;
+        };
+
+        // Классифицирует count подряд идущих блоков по 64 байта
+        using ClassifyFn = void (*)(const char *data, size_t count, BlockMasks *out);
+
+        enum CharClass : uint8_t
+        {
+            kOther = 0,
+            kQuote = 1,
+            kBackslash = 2,
+            kSpace = 4,
+            kOp = 8,
+        };
+
+        struct ClassTable
+        {
+            uint8_t classes[256] = {};
+
+            ClassTable()
+            {
+                classes[static_cast<uint8_t>('"')] = kQuote;
+                classes[static_cast<uint8_t>('\\')] = kBackslash;
+                for (char c : {' ', '\t', '\n', '\r'})
+                {
+                    classes[static_cast<uint8_t>(c)] = kSpace;
+                }
+                for (char c : {'{', '}', '[', ']', ':', ','})
+                {
+                    classes[static_cast<uint8_t>(c)] = kOp;
+                }
+            }
+        };
+
+        const ClassTable kClassTable;
+
+        void ClassifyScalar(const char *data, size_t count, BlockMasks *out)
+        {
+            for (size_t block = 0; block < count; ++block, data += StructuralScanner::kBlockSize)
+            {
+                BlockMasks masks;
+                for (size_t i = 0; i < StructuralScanner::kBlockSize; ++i)
+                {
+                    const uint8_t cls = kClassTable.classes[static_cast<uint8_t>(data[i])];
+                    const uint64_t bit = uint64_t{1} << i;
+                    masks.quote |= (cls & kQuote) ? bit : 0;
+                    masks.backslash |= (cls & kBackslash) ? bit : 0;
+                    masks.space |= (cls & kSpace) ? bit : 0;
+                    masks.op |= (cls & kOp) ? bit : 0;
+                }
+                out[block] = masks;
+            }
+        }
+
+#ifdef JSON_INDEX_X86
+        // '[' и ']' отличаются от '{' и '}' только битом 0x20,
+        // поэтому скобки обоих видов находятся двумя сравнениями после c | 0x20
+        void ClassifySse2(const char *data, size_t count, BlockMasks *out)
+        {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i tab = _mm_set1_epi8('\t');
+            const __m128i lf = _mm_set1_epi8('\n');
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i lower = _mm_set1_epi8(0x20);
+            const __m128i open_brace = _mm_set1_epi8('{');
+            const __m128i close_brace = _mm_set1_epi8('}');
+            const __m128i colon = _mm_set1_epi8(':');
+            const __m128i comma = _mm_set1_epi8(',');
+
+            for (size_t block = 0; block < count; ++block, data += StructuralScanner::kBlockSize)
+            {
+                BlockMasks masks;
+                for (int part = 0; part < 4; ++part)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + part * 16));
+                    const __m128i folded = _mm_or_si128(v, lower);
+                    const __m128i is_space = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+                    const __m128i is_op = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(folded, open_brace), _mm_cmpeq_epi8(folded, close_brace)),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+                    const int shift = part * 16;
+                    masks.quote |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))} << shift;
+                    masks.backslash |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))} << shift;
+                    masks.space |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(is_space))} << shift;
+                    masks.op |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(is_op))} << shift;
+                }
+                out[block] = masks;
+            }
+        }
+
+        __attribute__((target("avx2"))) void ClassifyAvx2(const char *data, size_t count, BlockMasks *out)
+        {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i space = _mm256_set1_epi8(' ');
+            const __m256i tab = _mm256_set1_epi8('\t');
+            const __m256i lf = _mm256_set1_epi8('\n');
+            const __m256i cr = _mm256_set1_epi8('\r');
+            const __m256i lower = _mm256_set1_epi8(0x20);
+            const __m256i open_brace = _mm256_set1_epi8('{');
+            const __m256i close_brace = _mm256_set1_epi8('}');
+            const __m256i colon = _mm256_set1_epi8(':');
+            const __m256i comma = _mm256_set1_epi8(',');
+
+            for (size_t block = 0; block < count; ++block, data += StructuralScanner::kBlockSize)
+            {
+                BlockMasks masks;
+                for (int part = 0; part < 2; ++part)
+                {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + part * 32));
+                    const __m256i folded = _mm256_or_si256(v, lower);
+                    const __m256i is_space = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+                    const __m256i is_op = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(folded, open_brace), _mm256_cmpeq_epi8(folded, close_brace)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+                    const int shift = part * 32;
+                    masks.quote |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))} << shift;
+                    masks.backslash |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))} << shift;
+                    masks.space |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(is_space))} << shift;
+                    masks.op |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(is_op))} << shift;
+                }
+                out[block] = masks;
+            }
+        }
+#endif
+
+        using FindSpecialFn = const char *(*)(const char *cur, const char *end);
+
+        bool IsStringSpecial(char c)
+        {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        }
+
+        const char *FindSpecialScalar(const char *cur, const char *end)
+        {
+            while (cur != end && !IsStringSpecial(*cur))
+            {
+                ++cur;
+            }
+            return cur;
+        }
+
+#ifdef JSON_INDEX_X86
+        // Маска символов блока, которые являются кавычкой, обратной косой чертой или управляющим символом.
+        // Беззнаковое v < 0x20 проверяется как min(v, 0x1f) == v
+        int SpecialMaskSse2(__m128i v)
+        {
+            const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+            const __m128i is_quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+            const __m128i is_backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+            return _mm_movemask_epi8(_mm_or_si128(is_control, _mm_or_si128(is_quote, is_backslash)));
+        }
+
+        const char *FindSpecialSse2(const char *cur, const char *end)
+        {
+            for (; end - cur >= 16; cur += 16)
+            {
+                if (const int mask = SpecialMaskSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cur))); mask != 0)
+                {
+                    return cur + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+            }
+            return FindSpecialScalar(cur, end);
+        }
+
+        __attribute__((target("avx2"))) const char *FindSpecialAvx2(const char *cur, const char *end)
+        {
+            const __m256i control_max = _mm256_set1_epi8(0x1f);
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            for (; end - cur >= 32; cur += 32)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur));
+                const __m256i is_special = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, control_max), v),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+                if (const int mask = _mm256_movemask_epi8(is_special); mask != 0)
+                {
+                    return cur + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+            }
+            // Остаток короче 32 байт досматриваем блоками по 16
+            return FindSpecialSse2(cur, end);
+        }
+#endif
+
+        FindSpecialFn GetSpecialFinder(ScanKernel kernel)
+        {
+            switch (kernel)
+            {
+#ifdef JSON_INDEX_X86
+            case ScanKernel::Avx2:
+                return FindSpecialAvx2;
+            case ScanKernel::Sse2:
+                return FindSpecialSse2;
+#endif
+            default:
+                return FindSpecialScalar;
+            }
+        }
+
+        ClassifyFn GetClassifier(ScanKernel kernel)
+        {
+            switch (kernel)
+            {
+#ifdef JSON_INDEX_X86
+            case ScanKernel::Avx2:
+                return ClassifyAvx2;
+            case ScanKernel::Sse2:
+                return ClassifySse2;
+#endif
+            default:
+                return ClassifyScalar;
+            }
+        }
+
+        // Бит i результата равен xor битов 0..i аргумента
+        uint64_t PrefixXor(uint64_t bits)
+        {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        int CountTrailingZeros(uint64_t bits)
+        {
+            return __builtin_ctzll(bits);
+        }
+    } // namespace
+
+    bool IsScanKernelSupported(ScanKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScanKernel::Scalar:
+            return true;
+#ifdef JSON_INDEX_X86
+        case ScanKernel::Sse2:
+            return true;
+        case ScanKernel::Avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    ScanKernel BestScanKernel()
+    {
+        static const ScanKernel best = []
+        {
+            for (ScanKernel kernel : {ScanKernel::Avx2, ScanKernel::Sse2})
+            {
+                if (IsScanKernelSupported(kernel))
+                {
+                    return kernel;
+                }
+            }
+            return ScanKernel::Scalar;
+        }();
+        return best;
+    }
+
+    const char *FindStringSpecial(const char *cur, const char *end)
+    {
+        static const FindSpecialFn find = GetSpecialFinder(BestScanKernel());
+        return find(cur, end);
+    }
+
+    const char *FindStringSpecial(const char *cur, const char *end, ScanKernel kernel)
+    {
+        return GetSpecialFinder(IsScanKernelSupported(kernel) ? kernel : ScanKernel::Scalar)(cur, end);
+    }
+
+    StructuralScanner::StructuralScanner(ScanKernel kernel)
+        : kernel_(IsScanKernelSupported(kernel) ? kernel : ScanKernel::Scalar)
+    {
+    }
+
+    size_t StructuralScanner::Scan(const char *data, size_t size, uint32_t *out)
+    {
+        // Маски считаются порциями, чтобы выбор реализации не стоил вызова на каждый блок
+        constexpr size_t kBatchBlocks = 64;
+        const ClassifyFn classify = GetClassifier(kernel_);
+        BlockMasks masks[kBatchBlocks];
+        uint32_t *const out_begin = out;
+
+        for (size_t offset = 0; offset < size;)
+        {
+            const size_t full_blocks = std::min((size - offset) / kBlockSize, kBatchBlocks);
+            size_t blocks = full_blocks;
+            if (blocks != 0)
+            {
+                classify(data + offset, blocks, masks);
+            }
+            else
+            {
+                // Хвост короче блока дополняем пробелами, которые не меняют разметку
+                char tail[kBlockSize];
+                std::memset(tail, ' ', kBlockSize);
+                std::memcpy(tail, data + offset, size - offset);
+                classify(tail, 1, masks);
+                blocks = 1;
+            }
+
+            for (size_t block = 0; block < blocks; ++block, offset += kBlockSize)
+            {
+                const BlockMasks &m = masks[block];
+
+                // Символы, экранированные обратной косой чертой. Серии подряд идущих
+                // обратных косых редки, поэтому обходим их побитово
+                uint64_t escaped = prev_escaped_;
+                uint64_t escapes = m.backslash & ~prev_escaped_;
+                prev_escaped_ = 0;
+                while (escapes != 0)
+                {
+                    const int i = CountTrailingZeros(escapes);
+                    escapes &= escapes - 1;
+                    if (i == 63)
+                    {
+                        prev_escaped_ = 1;
+                        break;
+                    }
+                    escaped |= uint64_t{1} << (i + 1);
+                    escapes &= ~(uint64_t{1} << (i + 1));
+                }
+
+                // Маска строк включает открывающую кавычку и не включает закрывающую
+                const uint64_t quotes = m.quote & ~escaped;
+                const uint64_t in_string = PrefixXor(quotes) ^ prev_in_string_;
+                prev_in_string_ = 0 - (in_string >> 63);
+
+                // Первые символы чисел и литералов: не пробел, не кавычка и не структурный символ,
+                // перед которым стоит пробел, кавычка или структурный символ
+                const uint64_t scalar = ~(m.space | m.op | m.quote | in_string);
+                const uint64_t scalar_starts = scalar & ~((scalar << 1) | prev_scalar_);
+                prev_scalar_ = scalar >> 63;
+
+                uint64_t structurals = (m.op & ~in_string) | (quotes & in_string) | scalar_starts;
+                const uint32_t base = static_cast<uint32_t>(offset);
+                while (structurals != 0)
+                {
+                    *out++ = base + static_cast<uint32_t>(CountTrailingZeros(structurals));
+                    structurals &= structurals - 1;
+                }
+            }
+        }
+        return static_cast<size_t>(out - out_begin);
+    }
+
+    TokenCursor::TokenCursor(std::string_view input, size_t window_size)
+        : input_(input),
+          // Размер окна кратен размеру блока, чтобы окна шли подряд без разрывов
+          window_size_(std::max((window_size + StructuralScanner::kBlockSize - 1) / StructuralScanner::kBlockSize, size_t{1}) *
+                       StructuralScanner::kBlockSize)
+    {
+    }
+
+    void TokenCursor::Reset(std::string_view input)
+    {
+        input_ = input;
+        scanned_ = 0;
+        window_ = nullptr;
+        count_ = 0;
+        pos_ = 0;
+        scanner_.Reset();
+    }
+
+    bool TokenCursor::Refill()
+    {
+        while (scanned_ < input_.size())
+        {
+            const size_t size = std::min(window_size_, input_.size() - scanned_);
+            // Небольшим документам не нужно место под индекс целого окна
+            const size_t capacity = (size + StructuralScanner::kBlockSize - 1) / StructuralScanner::kBlockSize * StructuralScanner::kBlockSize;
+            if (positions_.size() < capacity)
+            {
+                positions_.resize(capacity);
+            }
+            window_ = input_.data() + scanned_;
+            count_ = scanner_.Scan(window_, size, positions_.data());
+            pos_ = 0;
+            scanned_ += size;
+            if (count_ != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace json::detail
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json::detail
+{
+
+    // Реализация классификации символов, используемая первым проходом
+    enum class ScanKernel
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // Лучшая реализация, доступная на текущем процессоре. Определяется при первом вызове
+    ScanKernel BestScanKernel();
+    bool IsScanKernelSupported(ScanKernel kernel);
+
+    // Возвращает первый символ из [cur, end), который является кавычкой, обратной косой чертой
+    // или управляющим символом (с кодом меньше 0x20), либо end, если таких нет. Вход просматривается
+    // блоками по 16 или 32 байта без чтения за пределами end. Используется для поиска конца
+    // участка строки, который можно скопировать целиком, при разборе и при печати
+    const char *FindStringSpecial(const char *cur, const char *end);
+    const char *FindStringSpecial(const char *cur, const char *end, ScanKernel kernel);
+
+    // Первый проход разбора. Блоками по 64 байта размечает вход и находит позиции
+    // структурных символов {}[]:, открывающих кавычек строк и первых символов
+    // остальных значений (чисел, true, false, null). Пробельные символы и содержимое
+    // строк в индекс не попадают. Состояние (незакрытая строка, незавершённая
+    // escape-последовательность) переносится между вызовами Scan
+    class StructuralScanner
+    {
+    public:
+        static constexpr size_t kBlockSize = 64;
+
+        explicit StructuralScanner(ScanKernel kernel = BestScanKernel());
+
+        // Размечает очередной участок входа [data, data + size) и записывает в out
+        // смещения найденных позиций относительно data. Участки должны идти подряд,
+        // размер каждого, кроме последнего, кратен kBlockSize. В out должно быть место
+        // как минимум под size, округлённый вверх до kBlockSize, элементов.
+        // Возвращает количество записанных позиций
+        size_t Scan(const char *data, size_t size, uint32_t *out);
+
+        // Сбрасывает состояние, перенесённое с предыдущих участков
+        void Reset()
+        {
+            prev_escaped_ = 0;
+            prev_in_string_ = 0;
+            prev_scalar_ = 0;
+        }
+
+        // Истина, если просмотренная часть входа заканчивается внутри строки
+        bool InString() const
+        {
+            return prev_in_string_ != 0;
+        }
+
+    private:
+        ScanKernel kernel_;
+        uint64_t prev_escaped_ = 0;
+        uint64_t prev_in_string_ = 0;
+        uint64_t prev_scalar_ = 0;
+    };
+
+    // Последовательно выдаёт начала токенов входа, строя структурный индекс
+    // окнами по window_size байт, так что расход памяти на индекс не зависит от размера документа
+    class TokenCursor
+    {
+    public:
+        static constexpr size_t kDefaultWindow = 64 * 1024;
+
+        explicit TokenCursor(std::string_view input = {}, size_t window_size = kDefaultWindow);
+
+        // Начинает обход нового входа, сохраняя выделенную под индекс память
+        void Reset(std::string_view input);
+
+        // Возвращает указатель на первый символ очередного токена или nullptr, если вход исчерпан
+        const char *Next()
+        {
+            if (pos_ == count_ && !Refill())
+            {
+                return nullptr;
+            }
+            return window_ + positions_[pos_++];
+        }
+
+    private:
+        bool Refill();
+
+        std::string_view input_;
+        size_t window_size_;
+        size_t scanned_ = 0;
+        const char *window_ = nullptr;
+        std::vector<uint32_t> positions_;
+        size_t count_ = 0;
+        size_t pos_ = 0;
+        StructuralScanner scanner_;
+    };
+
+    // Смещения всех токенов входа от его начала. Вход размечается окнами TokenCursor, так что
+    // сверх самого индекса память нужна лишь под одно окно. Вход должен быть короче 4 ГиБ
+    inline std::vector<uint32_t> BuildTokenIndex(std::string_view input)
+    {
+        TokenCursor cursor(input);
+        std::vector<uint32_t> tokens;
+        while (const char *token = cursor.Next())
+        {
+            tokens.push_back(static_cast<uint32_t>(token - input.data()));
+        }
+        tokens.shrink_to_fit();
+        return tokens;
+    }
+
+} // namespace json::detail
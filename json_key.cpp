@@ -0,0 +1,95 @@
+#include "json_key.h"
+
+#include <mutex>
+
+namespace json
+{
+
+    namespace
+    {
+        // Добавляет ссылку на запись, если та ещё не начала удаляться
+        bool TryAcquire(detail::KeyEntry &entry)
+        {
+            size_t refs = entry.refs.load(std::memory_order_relaxed);
+            while (refs != 0)
+            {
+                if (entry.refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    Key::Key(std::string_view value)
+        : Key(KeyTable::Shared()->Intern(value))
+    {
+    }
+
+    void Key::Release(detail::KeyEntry *entry) noexcept
+    {
+        {
+            KeyTable &table = *entry->table;
+            std::unique_lock lock(table.mutex_);
+            // Пока блокировка не была взята, Intern мог заменить запись новой
+            if (const auto it = table.index_.find(entry->value); it != table.index_.end() && it->second == entry)
+            {
+                table.index_.erase(it);
+            }
+        }
+        // Запись держит таблицу, поэтому удаляется после снятия блокировки
+        delete entry;
+    }
+
+    std::shared_ptr<KeyTable> KeyTable::Create()
+    {
+        std::shared_ptr<KeyTable> table(new KeyTable());
+        table->self_ = table;
+        return table;
+    }
+
+    const std::shared_ptr<KeyTable> &KeyTable::Shared()
+    {
+        // Не разрушается, чтобы ключи оставались действительными и в деструкторах статических объектов
+        static const auto *table = new std::shared_ptr<KeyTable>(Create());
+        return *table;
+    }
+
+    Key KeyTable::Intern(std::string_view value)
+    {
+        if (value.empty())
+        {
+            return Key();
+        }
+        {
+            std::shared_lock lock(mutex_);
+            if (const auto it = index_.find(value); it != index_.end() && TryAcquire(*it->second))
+            {
+                return Key(it->second);
+            }
+        }
+        std::unique_lock lock(mutex_);
+        // Пока блокировка была снята, ключ мог добавить другой поток
+        const auto it = index_.find(value);
+        if (it != index_.end())
+        {
+            if (TryAcquire(*it->second))
+            {
+                return Key(it->second);
+            }
+            // Последний ключ записи уже удаляется, её место займёт новая
+            index_.erase(it);
+        }
+        auto *entry = new detail::KeyEntry(value, self_.lock());
+        index_.emplace(entry->value, entry);
+        return Key(entry);
+    }
+
+    size_t KeyTable::Size() const
+    {
+        std::shared_lock lock(mutex_);
+        return index_.size();
+    }
+
+} // namespace json
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace json
+{
+
+    class KeyTable;
+
+    namespace detail
+    {
+        // Строка ключа в таблице. Запись удаляется из таблицы, когда исчезает последний
+        // ссылающийся на неё Key, и до тех пор держит саму таблицу
+        struct KeyEntry
+        {
+            KeyEntry(std::string_view value, std::shared_ptr<KeyTable> table)
+                : value(value), table(std::move(table))
+            {
+            }
+
+            const std::string value;
+            std::atomic<size_t> refs{1};
+            const std::shared_ptr<KeyTable> table;
+        };
+    } // namespace detail
+
+    // Ключ словаря, хранящийся в таблице KeyTable в единственном экземпляре.
+    // Занимает размер указателя, копируется без выделения памяти, а равенство ключей
+    // одной таблицы проверяется сравнением указателей. Упорядочивается как строка.
+    // Ключ, созданный из строки, берётся из таблицы KeyTable::Shared()
+    class Key
+    {
+    public:
+        Key() noexcept = default;
+        Key(std::string_view value);
+        Key(const std::string &value)
+            : Key(std::string_view(value))
+        {
+        }
+        Key(const char *value)
+            : Key(std::string_view(value))
+        {
+        }
+
+        Key(const Key &other) noexcept
+            : entry_(other.entry_)
+        {
+            if (entry_ != nullptr)
+            {
+                entry_->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        Key(Key &&other) noexcept
+            : entry_(std::exchange(other.entry_, nullptr))
+        {
+        }
+
+        Key &operator=(const Key &other) noexcept
+        {
+            Key(other).Swap(*this);
+            return *this;
+        }
+
+        Key &operator=(Key &&other) noexcept
+        {
+            Key(std::move(other)).Swap(*this);
+            return *this;
+        }
+
+        ~Key()
+        {
+            if (entry_ != nullptr && entry_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                Release(entry_);
+            }
+        }
+
+        const std::string &GetString() const
+        {
+            static const std::string empty;
+            return entry_ != nullptr ? entry_->value : empty;
+        }
+
+        operator const std::string &() const
+        {
+            return GetString();
+        }
+
+        operator std::string_view() const
+        {
+            return GetString();
+        }
+
+        // Одинаковые строки одной таблицы — это один и тот же ключ, поэтому строки
+        // сравниваются только у ключей из разных таблиц
+        friend bool operator==(const Key &lhs, const Key &rhs)
+        {
+            if (lhs.entry_ == rhs.entry_)
+            {
+                return true;
+            }
+            if (lhs.entry_ == nullptr || rhs.entry_ == nullptr || lhs.entry_->table == rhs.entry_->table)
+            {
+                return false;
+            }
+            return lhs.entry_->value == rhs.entry_->value;
+        }
+
+        friend bool operator!=(const Key &lhs, const Key &rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const Key &lhs, const Key &rhs)
+        {
+            return lhs.entry_ != rhs.entry_ && lhs.GetString() < rhs.GetString();
+        }
+
+        // Сравнение со строками без помещения строки в таблицу
+        template <typename String, typename = std::enable_if_t<std::is_convertible_v<const String &, std::string_view>>>
+        friend bool operator==(const Key &lhs, const String &rhs)
+        {
+            return std::string_view(lhs.GetString()) == std::string_view(rhs);
+        }
+
+        template <typename String, typename = std::enable_if_t<std::is_convertible_v<const String &, std::string_view>>>
+        friend bool operator==(const String &lhs, const Key &rhs)
+        {
+            return rhs == lhs;
+        }
+
+        template <typename String, typename = std::enable_if_t<std::is_convertible_v<const String &, std::string_view>>>
+        friend bool operator!=(const Key &lhs, const String &rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+        template <typename String, typename = std::enable_if_t<std::is_convertible_v<const String &, std::string_view>>>
+        friend bool operator!=(const String &lhs, const Key &rhs)
+        {
+            return !(rhs == lhs);
+        }
+
+    private:
+        friend class KeyTable;
+
+        // Забирает ссылку на entry, уже учтённую в entry->refs
+        explicit Key(detail::KeyEntry *entry) noexcept
+            : entry_(entry)
+        {
+        }
+
+        void Swap(Key &other) noexcept
+        {
+            std::swap(entry_, other.entry_);
+        }
+
+        // Удаляет запись, на которую не осталось ключей
+        static void Release(detail::KeyEntry *entry) noexcept;
+
+        detail::KeyEntry *entry_ = nullptr;
+    };
+
+    // Таблица строк ключей. Строка хранится, пока на неё ссылается хотя бы один Key, так что
+    // таблица занимает память только под ключи живых документов. Методы можно вызывать из разных потоков.
+    // Loader по умолчанию заводит собственную таблицу, общую таблицу Shared() или любую другую
+    // можно передать через ParseOptions::key_table, чтобы документы разделяли ключи
+    class KeyTable
+    {
+    public:
+        static std::shared_ptr<KeyTable> Create();
+        // Таблица для ключей, созданных из строк вне разбора
+        static const std::shared_ptr<KeyTable> &Shared();
+
+        KeyTable(const KeyTable &) = delete;
+        KeyTable &operator=(const KeyTable &) = delete;
+
+        Key Intern(std::string_view value);
+
+        // Количество различных строк, на которые ссылаются ключи
+        size_t Size() const;
+
+    private:
+        friend class Key;
+
+        KeyTable() = default;
+
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string_view, detail::KeyEntry *> index_;
+        std::weak_ptr<KeyTable> self_;
+    };
+
+} // namespace json
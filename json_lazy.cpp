@@ -0,0 +1,376 @@
+#include "json_lazy.h"
+#include "json_node_builder.h"
+#include "json_parser.h"
+#include "json_sax.h"
+
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace json
+{
+
+    namespace
+    {
+        [[noreturn]] void ThrowTypeError()
+        {
+            throw(std::logic_error("value holds different type"));
+        }
+    } // namespace
+
+    struct detail::LazyIndex
+    {
+        std::string_view input;
+        // Смещения токенов от начала входа
+        std::vector<uint32_t> tokens;
+        // Номер токена, следующего за значением, которое начинается с данного токена.
+        // Для контейнеров это токен за парной закрывающей скобкой
+        std::vector<uint32_t> next;
+
+        // Собранные по AsString, AsArray и AsMap значения по номеру токена
+        mutable std::mutex cache_mutex;
+        mutable std::unordered_map<uint32_t, Node> cache;
+        // Ключи словарей, собранных из документа
+        KeyMaker make_key;
+
+        const char *At(uint32_t token) const
+        {
+            return input.data() + tokens[token];
+        }
+
+        // Раскодирует строку или ключ, начинающиеся с кавычки в токене token
+        std::string_view DecodeString(uint32_t token, std::string &scratch) const
+        {
+            const char *cur = At(token) + 1;
+            std::string_view value;
+            detail::ParseString(cur, input.data() + input.size(), scratch, value);
+            return value;
+        }
+
+        // Вызывает f(token) для каждого элемента массива, начинающегося в токене array
+        template <typename F>
+        void ForEachElement(uint32_t array, F &&f) const
+        {
+            uint32_t token = array + 1;
+            if (*At(token) == ']')
+            {
+                return;
+            }
+            while (true)
+            {
+                if (!f(token))
+                {
+                    return;
+                }
+                token = next[token];
+                if (*At(token) == ']')
+                {
+                    return;
+                }
+                // Пропускаем запятую
+                ++token;
+            }
+        }
+
+        // Вызывает f(key_token, value_token) для каждой пары словаря, начинающегося в токене dict
+        template <typename F>
+        void ForEachEntry(uint32_t dict, F &&f) const
+        {
+            uint32_t token = dict + 1;
+            if (*At(token) == '}')
+            {
+                return;
+            }
+            while (true)
+            {
+                // За ключом следуют двоеточие и значение
+                const uint32_t value = token + 2;
+                if (!f(token, value))
+                {
+                    return;
+                }
+                token = next[value];
+                if (*At(token) == '}')
+                {
+                    return;
+                }
+                ++token;
+            }
+        }
+
+        Node Build(uint32_t token) const
+        {
+            switch (*At(token))
+            {
+            case '[':
+            {
+                Array array;
+                ForEachElement(token, [this, &array](uint32_t element)
+                               {
+                                   array.push_back(Build(element));
+                                   return true; });
+                return array;
+            }
+            case '{':
+            {
+                std::vector<std::pair<Dict::key_type, Node>> entries;
+                std::string scratch;
+                ForEachEntry(token, [this, &entries, &scratch](uint32_t key, uint32_t value)
+                             {
+                                 entries.emplace_back(make_key(DecodeString(key, scratch)), Build(value));
+                                 return true; });
+                return Dict(make_move_iterator(entries.begin()), make_move_iterator(entries.end()));
+            }
+            case '"':
+            {
+                std::string scratch;
+                return std::string(DecodeString(token, scratch));
+            }
+            default:
+                return LazyNode(this, token).AsScalar();
+            }
+        }
+    };
+
+    char LazyNode::FirstChar() const
+    {
+        return *index_->At(token_);
+    }
+
+    bool LazyNode::IsNumber() const
+    {
+        const char c = FirstChar();
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    Node LazyNode::AsScalar() const
+    {
+        const char *cur = index_->At(token_);
+        const char *end = index_->input.data() + index_->input.size();
+        const char c = *cur;
+        if (c == '"' || c == '[' || c == '{')
+        {
+            ThrowTypeError();
+        }
+        if (c >= 'a' && c <= 'z')
+        {
+            detail::Literal literal;
+            detail::ParseLiteral(cur, end, literal);
+            return literal == detail::Literal::Null ? Node(nullptr) : Node(literal == detail::Literal::True);
+        }
+        detail::Number number;
+        detail::ParseNumber(cur, end, number);
+        return std::visit([](auto value)
+                          { return Node(value); },
+                          number);
+    }
+
+    const Node &LazyNode::Materialized() const
+    {
+        {
+            std::lock_guard lock(index_->cache_mutex);
+            if (const auto it = index_->cache.find(token_); it != index_->cache.end())
+            {
+                return it->second;
+            }
+        }
+        // Собираем без блокировки: другие потоки могут тем временем обращаться к другим значениям
+        Node node = index_->Build(token_);
+        std::lock_guard lock(index_->cache_mutex);
+        return index_->cache.try_emplace(token_, move(node)).first->second;
+    }
+
+    // LazyNode::Is
+    bool LazyNode::IsNull() const { return FirstChar() == 'n'; }
+    bool LazyNode::IsArray() const { return FirstChar() == '['; }
+    bool LazyNode::IsMap() const { return FirstChar() == '{'; }
+    bool LazyNode::IsBool() const { return FirstChar() == 't' || FirstChar() == 'f'; }
+    // Числа разбираются, только если значение начинается как число: для строк и контейнеров
+    // AsScalar выбрасывает исключение, а предикат должен вернуть false
+    bool LazyNode::IsInt() const { return IsNumber() && AsScalar().IsInt(); }
+    bool LazyNode::IsInt64() const { return IsNumber() && AsScalar().IsInt64(); }
+    bool LazyNode::IsUint64() const { return IsNumber() && AsScalar().IsUint64(); }
+    bool LazyNode::IsPureDouble() const { return IsNumber() && AsScalar().IsPureDouble(); }
+    bool LazyNode::IsDouble() const { return IsNumber() && AsScalar().IsDouble(); }
+    bool LazyNode::IsString() const { return FirstChar() == '"'; }
+
+    // LazyNode::As
+    bool LazyNode::AsBool() const { return AsScalar().AsBool(); }
+    int LazyNode::AsInt() const { return AsScalar().AsInt(); }
+    int64_t LazyNode::AsInt64() const { return AsScalar().AsInt64(); }
+    uint64_t LazyNode::AsUint64() const { return AsScalar().AsUint64(); }
+    double LazyNode::AsDouble() const { return AsScalar().AsDouble(); }
+
+    const std::string &LazyNode::AsString() const
+    {
+        if (!IsString())
+        {
+            ThrowTypeError();
+        }
+        return Materialized().AsString();
+    }
+
+    const Array &LazyNode::AsArray() const
+    {
+        if (!IsArray())
+        {
+            ThrowTypeError();
+        }
+        return Materialized().AsArray();
+    }
+
+    const Dict &LazyNode::AsMap() const
+    {
+        if (!IsMap())
+        {
+            ThrowTypeError();
+        }
+        return Materialized().AsMap();
+    }
+
+    size_t LazyNode::Size() const
+    {
+        size_t size = 0;
+        const auto count = [&size](auto...)
+        {
+            ++size;
+            return true;
+        };
+        if (IsArray())
+        {
+            index_->ForEachElement(token_, count);
+        }
+        else if (IsMap())
+        {
+            index_->ForEachEntry(token_, count);
+        }
+        else
+        {
+            ThrowTypeError();
+        }
+        return size;
+    }
+
+    LazyNode LazyNode::At(size_t index) const
+    {
+        if (!IsArray())
+        {
+            ThrowTypeError();
+        }
+        std::optional<uint32_t> found;
+        index_->ForEachElement(token_, [&index, &found](uint32_t element)
+                               {
+                                   if (index-- == 0)
+                                   {
+                                       found = element;
+                                   }
+                                   return !found; });
+        if (!found)
+        {
+            throw std::out_of_range("array index is out of range");
+        }
+        return LazyNode(index_, *found);
+    }
+
+    LazyNode LazyNode::At(std::string_view key) const
+    {
+        if (const auto value = Find(key))
+        {
+            return *value;
+        }
+        throw std::out_of_range("key is not found");
+    }
+
+    std::optional<LazyNode> LazyNode::Find(std::string_view key) const
+    {
+        if (!IsMap())
+        {
+            ThrowTypeError();
+        }
+        // Как и при полном разборе, из повторяющихся ключей действует первый
+        std::optional<uint32_t> found;
+        std::string scratch;
+        index_->ForEachEntry(token_, [this, key, &found, &scratch](uint32_t key_token, uint32_t value)
+                             {
+                                 if (index_->DecodeString(key_token, scratch) == key)
+                                 {
+                                     found = value;
+                                 }
+                                 return !found; });
+        if (!found)
+        {
+            return std::nullopt;
+        }
+        return LazyNode(index_, *found);
+    }
+
+    Node LazyNode::Materialize() const
+    {
+        return index_->Build(token_);
+    }
+
+    LazyDocument::LazyDocument(std::unique_ptr<detail::LazyIndex> index)
+        : index_(move(index))
+    {
+    }
+
+    LazyDocument::LazyDocument(LazyDocument &&) noexcept = default;
+    LazyDocument &LazyDocument::operator=(LazyDocument &&) noexcept = default;
+    LazyDocument::~LazyDocument() = default;
+
+    LazyNode LazyDocument::GetRoot() const
+    {
+        return LazyNode(index_.get(), 0);
+    }
+
+    Result<LazyDocument> TryLoadLazy(std::string_view input)
+    {
+        // Смещения токенов хранятся в 32 битах
+        if (input.size() > numeric_limits<uint32_t>::max())
+        {
+            return detail::MakeParseError(ParseErrorCode::InputTooLarge, input, 0);
+        }
+
+        // Значения не нужны, пока к ним не обратятся, поэтому достаточно проверить грамматику
+        detail::ParserContext context;
+        BaseHandler validator;
+        if (const auto error = detail::TryParse(input, validator, context))
+        {
+            return *error;
+        }
+
+        auto index = make_unique<detail::LazyIndex>();
+        index->input = input;
+        index->tokens = detail::BuildTokenIndex(input);
+        index->next.resize(index->tokens.size());
+        std::vector<uint32_t> open;
+        for (uint32_t token = 0; token < index->tokens.size(); ++token)
+        {
+            index->next[token] = token + 1;
+            switch (*index->At(token))
+            {
+            case '[':
+            case '{':
+                open.push_back(token);
+                break;
+            case ']':
+            case '}':
+                index->next[open.back()] = token + 1;
+                open.pop_back();
+                break;
+            default:
+                break;
+            }
+        }
+        return LazyDocument(move(index));
+    }
+
+    LazyDocument LoadLazy(std::string_view input)
+    {
+        return TryLoadLazy(input).GetValue();
+    }
+
+} // namespace json
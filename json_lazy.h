@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "json.h"
+
+namespace json::detail
+{
+    // Структурный индекс ленивого документа
+    struct LazyIndex;
+} // namespace json::detail
+
+namespace json
+{
+
+    class LazyDocument;
+
+    // Значение ленивого документа. Хранит лишь номер токена в структурном индексе,
+    // поэтому копируется дёшево. Действительно, пока жив документ.
+    // Скалярные значения разбираются из исходного текста при каждом обращении,
+    // строки и контейнеры по AsString, AsArray и AsMap собираются в Node при первом
+    // обращении и запоминаются в документе. Обход через At и Size ничего не собирает
+    class LazyNode
+    {
+    public:
+        bool IsNull() const;
+        bool IsArray() const;
+        bool IsMap() const;
+        bool IsBool() const;
+        bool IsInt() const;
+        bool IsInt64() const;
+        bool IsUint64() const;
+        bool IsPureDouble() const;
+        bool IsDouble() const;
+        bool IsString() const;
+
+        bool AsBool() const;
+        int AsInt() const;
+        int64_t AsInt64() const;
+        uint64_t AsUint64() const;
+        double AsDouble() const;
+        const std::string &AsString() const;
+        const Array &AsArray() const;
+        const Dict &AsMap() const;
+
+        // Количество элементов массива или пар словаря
+        size_t Size() const;
+        // Элемент массива. При выходе за границы выбрасывает std::out_of_range
+        LazyNode At(size_t index) const;
+        // Значение по ключу словаря. Если ключа нет, выбрасывает std::out_of_range
+        LazyNode At(std::string_view key) const;
+        std::optional<LazyNode> Find(std::string_view key) const;
+
+        // Собирает копию поддерева, не запоминая её в документе
+        Node Materialize() const;
+
+    private:
+        friend class LazyDocument;
+        friend struct detail::LazyIndex;
+
+        LazyNode(const detail::LazyIndex *index, uint32_t token)
+            : index_(index), token_(token)
+        {
+        }
+
+        char FirstChar() const;
+        // Истина, если значение — число
+        bool IsNumber() const;
+        // Узел для null, true, false и чисел. Для строк и контейнеров выбрасывает std::logic_error
+        Node AsScalar() const;
+        // Собранное значение из кэша документа
+        const Node &Materialized() const;
+
+        const detail::LazyIndex *index_;
+        uint32_t token_;
+    };
+
+    // Документ, разбор которого лишь проверяет вход и строит структурный индекс:
+    // позиции токенов и парные скобки контейнеров. Значения, к которым не обращались,
+    // так и не превращаются в Node. Документ ссылается на входной буфер, поэтому буфер
+    // должен жить не меньше документа. Размер входа ограничен 4 ГиБ: для более длинного
+    // TryLoadLazy возвращает ошибку InputTooLarge.
+    // Обращаться к документу можно из нескольких потоков одновременно
+    class LazyDocument
+    {
+    public:
+        LazyDocument(LazyDocument &&) noexcept;
+        LazyDocument &operator=(LazyDocument &&) noexcept;
+        ~LazyDocument();
+
+        LazyNode GetRoot() const;
+
+    private:
+        friend Result<LazyDocument> TryLoadLazy(std::string_view input);
+
+        explicit LazyDocument(std::unique_ptr<detail::LazyIndex> index);
+
+        std::unique_ptr<detail::LazyIndex> index_;
+    };
+
+    // При ошибке разбора выбрасывает ParsingError
+    LazyDocument LoadLazy(std::string_view input);
+    Result<LazyDocument> TryLoadLazy(std::string_view input);
+
+} // namespace json
@@ -0,0 +1,532 @@
+#include "json_lines.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+using namespace std;
+
+namespace json
+{
+
+    namespace
+    {
+        bool IsBlank(std::string_view line)
+        {
+            for (char c : line)
+            {
+                if (c != ' ' && c != '\t' && c != '\r')
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Ошибка разбора с номером строки входа в тексте сообщения
+        ParsingError LineError(size_t line_number, const ParseError &error)
+        {
+            return ParsingError("line "s + std::to_string(line_number) + ": "s + error.ToString());
+        }
+
+        std::unique_ptr<std::istream> OpenFile(const std::string &path)
+        {
+            auto file = make_unique<std::ifstream>(path, std::ios::binary);
+            if (!*file)
+            {
+                throw std::runtime_error("Failed to open "s + path);
+            }
+            return file;
+        }
+
+        // Очередь ограниченной ёмкости. После Close новые элементы не принимаются,
+        // а Pop возвращает оставшиеся элементы и затем std::nullopt
+        template <typename T>
+        class BoundedQueue
+        {
+        public:
+            explicit BoundedQueue(size_t capacity)
+                : capacity_(capacity)
+            {
+            }
+
+            bool Push(T value)
+            {
+                std::unique_lock lock(mutex_);
+                not_full_.wait(lock, [this]
+                               { return closed_ || queue_.size() < capacity_; });
+                if (closed_)
+                {
+                    return false;
+                }
+                queue_.push_back(std::move(value));
+                not_empty_.notify_one();
+                return true;
+            }
+
+            std::optional<T> Pop()
+            {
+                std::unique_lock lock(mutex_);
+                not_empty_.wait(lock, [this]
+                                { return closed_ || !queue_.empty(); });
+                if (queue_.empty())
+                {
+                    return std::nullopt;
+                }
+                T value = std::move(queue_.front());
+                queue_.pop_front();
+                not_full_.notify_one();
+                return value;
+            }
+
+            void Close()
+            {
+                std::lock_guard lock(mutex_);
+                closed_ = true;
+                not_empty_.notify_all();
+                not_full_.notify_all();
+            }
+
+        private:
+            size_t capacity_;
+            std::deque<T> queue_;
+            bool closed_ = false;
+            std::mutex mutex_;
+            std::condition_variable not_empty_;
+            std::condition_variable not_full_;
+        };
+
+        // Порция входа, состоящая из целых строк
+        struct Chunk
+        {
+            size_t index = 0;
+            size_t first_line = 0;
+            std::string text;
+        };
+
+        struct ParsedChunk
+        {
+            std::vector<std::pair<size_t, Document>> docs;
+            // Ошибка разбора; документы из строк до неё находятся в docs
+            std::exception_ptr error;
+        };
+
+        class ParallelLinesReader
+        {
+        public:
+            ParallelLinesReader(std::istream &input, const LineHandler &handler, const ParallelReadOptions &options)
+                : input_(input),
+                  handler_(handler),
+                  ordered_(options.order == DeliveryOrder::Ordered),
+                  threads_(options.threads != 0 ? options.threads : std::max(std::thread::hardware_concurrency(), 1u)),
+                  chunk_size_(std::max(options.chunk_size, size_t{1})),
+                  max_in_flight_(options.max_chunks_in_flight != 0 ? options.max_chunks_in_flight : 2 * threads_),
+                  tasks_(max_in_flight_)
+            {
+            }
+
+            void Run()
+            {
+                std::vector<std::thread> threads;
+                threads.reserve(threads_ + 1);
+                try
+                {
+                    threads.emplace_back([this]
+                                         { ReadChunks(); });
+                    for (size_t i = 0; i < threads_; ++i)
+                    {
+                        threads.emplace_back([this]
+                                             { ParseChunks(); });
+                    }
+                    if (ordered_)
+                    {
+                        DeliverInOrder();
+                    }
+                }
+                catch (...)
+                {
+                    Fail(std::current_exception());
+                }
+                for (std::thread &thread : threads)
+                {
+                    thread.join();
+                }
+                if (error_)
+                {
+                    std::rethrow_exception(error_);
+                }
+            }
+
+        private:
+            // Поток чтения: делит вход на порции по границам строк
+            void ReadChunks()
+            {
+                try
+                {
+                    std::string carry;
+                    size_t index = 0;
+                    size_t line = 1;
+                    bool eof = false;
+                    while (!eof && AcquireSlot())
+                    {
+                        Chunk chunk{index, line, TakeBuffer()};
+                        std::string &text = chunk.text;
+                        text.swap(carry);
+                        carry.clear();
+
+                        size_t last_newline = std::string::npos;
+                        while (last_newline == std::string::npos && !eof)
+                        {
+                            const size_t old_size = text.size();
+                            text.resize(old_size + chunk_size_);
+                            input_.read(text.data() + old_size, static_cast<std::streamsize>(chunk_size_));
+                            const size_t read = static_cast<size_t>(input_.gcount());
+                            text.resize(old_size + read);
+                            eof = read < chunk_size_ || !input_;
+                            last_newline = text.rfind('\n');
+                        }
+                        if (!eof)
+                        {
+                            // Недочитанная строка переходит в следующую порцию
+                            carry.assign(text, last_newline + 1);
+                            text.resize(last_newline + 1);
+                        }
+                        if (text.empty())
+                        {
+                            ReleaseSlot();
+                            break;
+                        }
+
+                        line += static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+                        if (!tasks_.Push(std::move(chunk)))
+                        {
+                            break;
+                        }
+                        ++index;
+                    }
+
+                    std::lock_guard lock(mutex_);
+                    total_chunks_ = index;
+                    reading_done_ = true;
+                    results_ready_.notify_all();
+                }
+                catch (...)
+                {
+                    Fail(std::current_exception());
+                }
+                tasks_.Close();
+            }
+
+            // Поток разбора
+            void ParseChunks()
+            {
+                Loader loader;
+                while (!stopped_)
+                {
+                    std::optional<Chunk> chunk = tasks_.Pop();
+                    if (!chunk)
+                    {
+                        break;
+                    }
+                    ParsedChunk parsed = ParseChunk(*chunk, loader);
+                    ReturnBuffer(std::move(chunk->text));
+
+                    if (ordered_)
+                    {
+                        std::lock_guard lock(mutex_);
+                        results_.emplace(chunk->index, std::move(parsed));
+                        results_ready_.notify_all();
+                        continue;
+                    }
+
+                    try
+                    {
+                        for (auto &[line, doc] : parsed.docs)
+                        {
+                            handler_(std::move(doc), line);
+                        }
+                        if (parsed.error)
+                        {
+                            std::rethrow_exception(parsed.error);
+                        }
+                    }
+                    catch (...)
+                    {
+                        Fail(std::current_exception());
+                        break;
+                    }
+                    ReleaseSlot();
+                }
+            }
+
+            ParsedChunk ParseChunk(const Chunk &chunk, Loader &loader)
+            {
+                ParsedChunk result;
+                const char *cur = chunk.text.data();
+                const char *end = cur + chunk.text.size();
+                for (size_t line = chunk.first_line; cur < end; ++line)
+                {
+                    const char *newline = static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+                    const char *line_end = newline != nullptr ? newline : end;
+                    const std::string_view text(cur, line_end - cur);
+                    cur = line_end + 1;
+                    if (IsBlank(text))
+                    {
+                        continue;
+                    }
+                    Result<Document> doc = loader.TryLoad(text);
+                    if (!doc)
+                    {
+                        result.error = std::make_exception_ptr(LineError(line, doc.GetError()));
+                        break;
+                    }
+                    result.docs.emplace_back(line, std::move(doc).GetValue());
+                }
+                return result;
+            }
+
+            // Передаёт документы обработчику в порядке порций, в вызывающем потоке
+            void DeliverInOrder()
+            {
+                for (size_t next = 0;; ++next)
+                {
+                    ParsedChunk parsed;
+                    {
+                        std::unique_lock lock(mutex_);
+                        results_ready_.wait(lock, [this, next]
+                                            { return stopped_ || results_.count(next) != 0 ||
+                                                     (reading_done_ && next == total_chunks_); });
+                        const auto it = results_.find(next);
+                        if (stopped_ || it == results_.end())
+                        {
+                            return;
+                        }
+                        parsed = std::move(it->second);
+                        results_.erase(it);
+                    }
+                    for (auto &[line, doc] : parsed.docs)
+                    {
+                        handler_(std::move(doc), line);
+                    }
+                    if (parsed.error)
+                    {
+                        std::rethrow_exception(parsed.error);
+                    }
+                    ReleaseSlot();
+                }
+            }
+
+            // Ограничивает число порций, прочитанных, но ещё не переданных обработчику
+            bool AcquireSlot()
+            {
+                std::unique_lock lock(mutex_);
+                slot_released_.wait(lock, [this]
+                                    { return stopped_ || in_flight_ < max_in_flight_; });
+                if (stopped_)
+                {
+                    return false;
+                }
+                ++in_flight_;
+                return true;
+            }
+
+            void ReleaseSlot()
+            {
+                std::lock_guard lock(mutex_);
+                --in_flight_;
+                slot_released_.notify_one();
+            }
+
+            std::string TakeBuffer()
+            {
+                std::lock_guard lock(mutex_);
+                if (free_buffers_.empty())
+                {
+                    return {};
+                }
+                std::string buffer = std::move(free_buffers_.back());
+                free_buffers_.pop_back();
+                buffer.clear();
+                return buffer;
+            }
+
+            void ReturnBuffer(std::string buffer)
+            {
+                std::lock_guard lock(mutex_);
+                free_buffers_.push_back(std::move(buffer));
+            }
+
+            // Запоминает первую ошибку и останавливает все потоки
+            void Fail(std::exception_ptr error)
+            {
+                {
+                    std::lock_guard lock(mutex_);
+                    if (!error_)
+                    {
+                        error_ = error;
+                    }
+                    stopped_ = true;
+                    results_ready_.notify_all();
+                    slot_released_.notify_all();
+                }
+                tasks_.Close();
+            }
+
+            std::istream &input_;
+            const LineHandler &handler_;
+            const bool ordered_;
+            const size_t threads_;
+            const size_t chunk_size_;
+            const size_t max_in_flight_;
+            BoundedQueue<Chunk> tasks_;
+
+            std::mutex mutex_;
+            std::condition_variable results_ready_;
+            std::condition_variable slot_released_;
+            std::map<size_t, ParsedChunk> results_;
+            std::vector<std::string> free_buffers_;
+            size_t in_flight_ = 0;
+            size_t total_chunks_ = 0;
+            bool reading_done_ = false;
+            std::atomic<bool> stopped_ = false;
+            std::exception_ptr error_;
+        };
+    } // namespace
+
+    LinesReader::LinesReader(std::istream &input, size_t chunk_size)
+        : input_(&input), chunk_size_(std::max(chunk_size, size_t{1}))
+    {
+    }
+
+    LinesReader::LinesReader(const std::string &path, size_t chunk_size)
+        : chunk_size_(std::max(chunk_size, size_t{1}))
+    {
+        try
+        {
+            mapped_ = MappedFile::TryMap(path);
+        }
+        catch (const std::system_error &)
+        {
+            throw std::runtime_error("Failed to open "s + path);
+        }
+        if (mapped_)
+        {
+            // Весь файл уже доступен, дочитывать нечего
+            data_ = mapped_->GetData().data();
+            end_ = mapped_->GetData().size();
+            eof_ = true;
+        }
+        else
+        {
+            owned_input_ = OpenFile(path);
+            input_ = owned_input_.get();
+        }
+    }
+
+    std::optional<Document> LinesReader::Next()
+    {
+        const auto line = NextLine();
+        if (!line)
+        {
+            return std::nullopt;
+        }
+        Result<Document> doc = loader_.TryLoad(*line);
+        if (!doc)
+        {
+            throw LineError(line_number_, doc.GetError());
+        }
+        return std::move(doc).GetValue();
+    }
+
+    size_t LinesReader::NextBatch(std::vector<Document> &batch, size_t max_count)
+    {
+        batch.clear();
+        while (batch.size() < max_count)
+        {
+            auto doc = Next();
+            if (!doc)
+            {
+                break;
+            }
+            batch.push_back(std::move(*doc));
+        }
+        return batch.size();
+    }
+
+    std::optional<std::string_view> LinesReader::NextLine()
+    {
+        while (true)
+        {
+            std::string_view line;
+            const char *data = data_;
+            const void *newline = std::memchr(data + scanned_, '\n', end_ - scanned_);
+            if (newline != nullptr)
+            {
+                const size_t line_end = static_cast<const char *>(newline) - data;
+                line = std::string_view(data + begin_, line_end - begin_);
+                begin_ = scanned_ = line_end + 1;
+            }
+            else if (!eof_)
+            {
+                FillBuffer();
+                continue;
+            }
+            else if (begin_ != end_)
+            {
+                // Последняя строка без перевода строки в конце
+                line = std::string_view(data + begin_, end_ - begin_);
+                begin_ = scanned_ = end_;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+
+            ++line_number_;
+            if (!IsBlank(line))
+            {
+                return line;
+            }
+        }
+    }
+
+    void LinesReader::FillBuffer()
+    {
+        // Переносим недочитанную строку в начало буфера
+        const size_t tail = end_ - begin_;
+        if (begin_ != 0)
+        {
+            std::memmove(buffer_.data(), buffer_.data() + begin_, tail);
+        }
+        scanned_ = end_ = tail;
+        begin_ = 0;
+
+        // Если строка длиннее буфера, буфер растёт
+        if (buffer_.size() - end_ < chunk_size_)
+        {
+            buffer_.resize(end_ + chunk_size_);
+        }
+        data_ = buffer_.data();
+        input_->read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+        const size_t read = static_cast<size_t>(input_->gcount());
+        end_ += read;
+        if (read == 0 || !*input_)
+        {
+            eof_ = true;
+        }
+    }
+
+    void ReadLinesParallel(std::istream &input, const LineHandler &handler, const ParallelReadOptions &options)
+    {
+        ParallelLinesReader(input, handler, options).Run();
+    }
+
+} // namespace json
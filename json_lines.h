@@ -0,0 +1,97 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "json_file.h"
+
+namespace json
+{
+
+    // Читает поток в формате JSON Lines (NDJSON): по одному документу в каждой строке.
+    // Вход считывается крупными порциями в буфер, который вместе с буферами разбора
+    // переиспользуется от записи к записи. Строки, состоящие из одних пробелов, пропускаются.
+    // Ошибка разбора выбрасывается как ParsingError с номером строки в тексте сообщения
+    class LinesReader
+    {
+    public:
+        static constexpr size_t kDefaultChunkSize = 1 << 20;
+
+        explicit LinesReader(std::istream &input, size_t chunk_size = kDefaultChunkSize);
+        // Открывает файл. Обычный файл отображается в память и читается без копирования в буфер,
+        // канал или устройство читаются порциями. Если файл открыть не удалось, выбрасывает std::runtime_error
+        explicit LinesReader(const std::string &path, size_t chunk_size = kDefaultChunkSize);
+
+        // Возвращает очередной документ или std::nullopt, если вход исчерпан
+        std::optional<Document> Next();
+
+        // Заменяет содержимое batch не более чем max_count очередными документами.
+        // Возвращает количество прочитанных документов, 0 означает конец входа
+        size_t NextBatch(std::vector<Document> &batch, size_t max_count);
+
+        // Возвращает очередную непустую строку без символа перевода строки или std::nullopt,
+        // если вход исчерпан. Строка действительна до следующего чтения из LinesReader
+        std::optional<std::string_view> NextLine();
+
+        // Номер (с единицы) последней прочитанной строки
+        size_t GetLineNumber() const
+        {
+            return line_number_;
+        }
+
+    private:
+        // Дочитывает очередную порцию входа вслед за недочитанной строкой
+        void FillBuffer();
+
+        std::shared_ptr<const MappedFile> mapped_;
+        std::unique_ptr<std::istream> owned_input_;
+        std::istream *input_ = nullptr;
+        size_t chunk_size_;
+        std::string buffer_;
+        // Начало буфера или отображённого файла, в которых ищутся строки
+        const char *data_ = buffer_.data();
+        size_t begin_ = 0;
+        size_t end_ = 0;
+        // Позиция, с которой продолжать поиск перевода строки после дочитывания
+        size_t scanned_ = 0;
+        bool eof_ = false;
+        size_t line_number_ = 0;
+        Loader loader_;
+    };
+
+    enum class DeliveryOrder
+    {
+        // Документы передаются в порядке следования строк, обработчик вызывается из вызывающего потока
+        Ordered,
+        // Документы передаются по мере разбора прямо из потоков-разборщиков,
+        // поэтому обработчик должен допускать одновременный вызов из нескольких потоков
+        Unordered,
+    };
+
+    struct ParallelReadOptions
+    {
+        // Количество потоков-разборщиков, 0 означает по числу ядер
+        size_t threads = 0;
+        // Вход делится на порции примерно такого размера по границам строк
+        size_t chunk_size = LinesReader::kDefaultChunkSize;
+        // Сколько порций может одновременно находиться в очереди и в обработке, 0 означает 2 * threads
+        size_t max_chunks_in_flight = 0;
+        DeliveryOrder order = DeliveryOrder::Ordered;
+    };
+
+    // Получает разобранный документ и номер строки, в которой он записан
+    using LineHandler = std::function<void(Document &&doc, size_t line_number)>;
+
+    // Разбирает поток JSON Lines в несколько потоков. Отдельный поток читает вход и делит его
+    // на порции по границам строк, порции через ограниченную очередь попадают к разборщикам.
+    // Первая ошибка разбора или исключение обработчика останавливает чтение и выбрасывается
+    // из функции; в режиме Ordered до этого будут переданы все документы из предшествующих строк
+    void ReadLinesParallel(std::istream &input, const LineHandler &handler, const ParallelReadOptions &options = {});
+
+} // namespace json
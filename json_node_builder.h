@@ -0,0 +1,158 @@
+#pragma once
+
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+
+namespace json::detail
+{
+
+    // Создаёт ключи словарей разбираемых документов. В сборке с JSON_INTERN_KEYS ключи
+    // берутся из table или, если она не задана, из собственной таблицы
+    class KeyMaker
+    {
+    public:
+        explicit KeyMaker(std::shared_ptr<KeyTable> table = nullptr)
+        {
+#if defined(JSON_INTERN_KEYS)
+            table_ = table ? std::move(table) : KeyTable::Create();
+#else
+            static_cast<void>(table);
+#endif
+        }
+
+        Dict::key_type operator()(std::string_view key) const
+        {
+#if defined(JSON_INTERN_KEYS)
+            return table_->Intern(key);
+#else
+            return Dict::key_type(key);
+#endif
+        }
+
+    private:
+#if defined(JSON_INTERN_KEYS)
+        std::shared_ptr<KeyTable> table_;
+#endif
+    };
+
+    // Собирает дерево Node из событий detail::Parser и detail::PushParser
+    class NodeBuilder
+    {
+    public:
+        explicit NodeBuilder(KeyMaker make_key = KeyMaker())
+            : make_key_(std::move(make_key))
+        {
+        }
+
+        void OnNull() { AddValue(Node(nullptr)); }
+        void OnBool(bool value) { AddValue(Node(value)); }
+        void OnInt(int value) { AddValue(Node(value)); }
+        void OnInt64(int64_t value) { AddValue(Node(value)); }
+        void OnUint64(uint64_t value) { AddValue(Node(value)); }
+        void OnDouble(double value) { AddValue(Node(value)); }
+        void OnString(std::string_view value)
+        {
+            // Раскодированные строки лежат в буфере разбора, и их приходится копировать
+            if (IsInSource(value))
+            {
+                AddValue(Node::FromBorrowedString(value));
+            }
+            else
+            {
+                AddValue(Node(std::string(value)));
+            }
+        }
+
+        void OnKey(std::string_view key)
+        {
+            entries_.emplace_back(make_key_(key), Node());
+        }
+
+        // Строки, лежащие в source, не копируются. Пустой source отключает заимствование
+        void SetSource(std::string_view source)
+        {
+            source_ = source;
+        }
+
+        void OnStartArray()
+        {
+            stack_.emplace_back().is_array = true;
+        }
+
+        void OnEndArray()
+        {
+            Node node(std::move(stack_.back().array));
+            stack_.pop_back();
+            AddValue(std::move(node));
+        }
+
+        void OnStartObject()
+        {
+            Frame &frame = stack_.emplace_back();
+            frame.is_array = false;
+            frame.first_entry = entries_.size();
+        }
+
+        void OnEndObject()
+        {
+            // Словарь строится разом из накопленных пар, что дешевле поштучной вставки
+            const auto first = entries_.begin() + stack_.back().first_entry;
+            Node node(Dict(std::make_move_iterator(first), std::make_move_iterator(entries_.end())));
+            entries_.erase(first, entries_.end());
+            stack_.pop_back();
+            AddValue(std::move(node));
+        }
+
+        Node ExtractRoot()
+        {
+            return std::move(root_);
+        }
+
+    private:
+        // Контейнер, который собирается в данный момент
+        struct Frame
+        {
+            bool is_array = false;
+            Array array;
+            // Начало пар словаря в entries_
+            size_t first_entry = 0;
+        };
+
+        void AddValue(Node node)
+        {
+            if (stack_.empty())
+            {
+                root_ = std::move(node);
+            }
+            else if (Frame &frame = stack_.back(); frame.is_array)
+            {
+                frame.array.push_back(std::move(node));
+            }
+            else
+            {
+                entries_.back().second = std::move(node);
+            }
+        }
+
+        bool IsInSource(std::string_view value) const
+        {
+            const std::less<const char *> less;
+            return !source_.empty() && !less(value.data(), source_.data()) && less(value.data(), source_.data() + source_.size());
+        }
+
+        KeyMaker make_key_;
+        std::string_view source_;
+        std::vector<Frame> stack_;
+        // Пары всех собираемых словарей. Ключ добавляется по OnKey, значение — следом за ним
+        std::vector<std::pair<Dict::key_type, Node>> entries_;
+        Node root_;
+    };
+
+} // namespace json::detail
@@ -0,0 +1,183 @@
+#include "json_output.h"
+#include "json_index.h"
+
+#include <cerrno>
+#include <charconv>
+#include <ostream>
+#include <system_error>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace json
+{
+
+    namespace
+    {
+        // Наибольшая длина записи double функцией std::to_chars в кратчайшем виде
+        constexpr size_t kMaxDoubleChars = 32;
+        constexpr size_t kMaxIntChars = 24;
+
+        // Символы строки, которые требуют экранирования
+        bool NeedsEscape(char c)
+        {
+            return c == '\\' || c == '"' || c == '\r' || c == '\n' || c == '\t';
+        }
+    } // namespace
+
+    OutputBuffer::OutputBuffer(std::ostream &output)
+        : sink_type_(SinkType::Stream), stream_(&output), buffer_(new char[kCapacity]), pos_(buffer_.get()), end_(pos_ + kCapacity)
+    {
+    }
+
+    OutputBuffer::OutputBuffer(std::string &output)
+        : sink_type_(SinkType::String), string_(&output), buffer_(new char[kCapacity]), pos_(buffer_.get()), end_(pos_ + kCapacity)
+    {
+    }
+
+    OutputBuffer::OutputBuffer(int fd)
+        : sink_type_(SinkType::Descriptor), fd_(fd), buffer_(new char[kCapacity]), pos_(buffer_.get()), end_(pos_ + kCapacity)
+    {
+    }
+
+    OutputBuffer::~OutputBuffer()
+    {
+        try
+        {
+            Flush();
+        }
+        catch (...)
+        {
+            // Ошибку записи можно узнать, вызвав Flush явно
+        }
+    }
+
+    void OutputBuffer::WriteInt(int64_t value)
+    {
+        char *first = Reserve(kMaxIntChars);
+        pos_ = std::to_chars(first, end_, value).ptr;
+    }
+
+    void OutputBuffer::WriteUint(uint64_t value)
+    {
+        char *first = Reserve(kMaxIntChars);
+        pos_ = std::to_chars(first, end_, value).ptr;
+    }
+
+    void OutputBuffer::WriteDouble(double value)
+    {
+        char *first = Reserve(kMaxDoubleChars);
+        pos_ = std::to_chars(first, end_, value).ptr;
+    }
+
+    void OutputBuffer::WriteString(std::string_view value)
+    {
+        Put('"');
+        const char *cur = value.data();
+        const char *end = cur + value.size();
+        while (cur != end)
+        {
+            // Участок без специальных символов копируем целиком
+            const char *run = cur;
+            cur = detail::FindStringSpecial(cur, end);
+            while (cur != end && !NeedsEscape(*cur))
+            {
+                // Управляющий символ, который выводится как есть
+                cur = detail::FindStringSpecial(cur + 1, end);
+            }
+            Write(std::string_view(run, cur - run));
+            if (cur == end)
+            {
+                break;
+            }
+
+            char *out = Reserve(2);
+            out[0] = '\\';
+            switch (*cur++)
+            {
+            case '\\':
+                out[1] = '\\';
+                break;
+            case '"':
+                out[1] = '"';
+                break;
+            case '\r':
+                out[1] = 'r';
+                break;
+            case '\n':
+                out[1] = 'n';
+                break;
+            default:
+                out[1] = 't';
+                break;
+            }
+            pos_ += 2;
+        }
+        Put('"');
+    }
+
+    void OutputBuffer::Flush()
+    {
+        Drain();
+        if (sink_type_ == SinkType::Stream)
+        {
+            stream_->flush();
+        }
+    }
+
+    void OutputBuffer::WriteSlow(std::string_view text)
+    {
+        Drain();
+        if (text.size() >= kCapacity)
+        {
+            // Крупный фрагмент передаём в приёмник сразу, минуя буфер
+            WriteToSink(text.data(), text.size());
+            return;
+        }
+        std::memcpy(pos_, text.data(), text.size());
+        pos_ += text.size();
+    }
+
+    void OutputBuffer::Drain()
+    {
+        char *begin = buffer_.get();
+        const size_t size = static_cast<size_t>(pos_ - begin);
+        // Буфер считается опустошённым, даже если запись не удалась, чтобы не повторять её в деструкторе
+        pos_ = begin;
+        if (size != 0)
+        {
+            WriteToSink(begin, size);
+        }
+    }
+
+    void OutputBuffer::WriteToSink(const char *data, size_t size)
+    {
+        switch (sink_type_)
+        {
+        case SinkType::Stream:
+            stream_->write(data, static_cast<std::streamsize>(size));
+            break;
+        case SinkType::String:
+            string_->append(data, size);
+            break;
+        case SinkType::Descriptor:
+            while (size != 0)
+            {
+                const ssize_t written = ::write(fd_, data, size);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "Failed to write JSON output");
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            break;
+        }
+    }
+
+} // namespace json
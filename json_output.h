@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace json
+{
+
+    // Накапливает вывод в буфере и передаёт его в приёмник (поток, строку или файловый дескриптор)
+    // крупными порциями. Остаток буфера передаётся при вызове Flush и в деструкторе
+    class OutputBuffer
+    {
+    public:
+        static constexpr size_t kCapacity = 64 * 1024;
+
+        explicit OutputBuffer(std::ostream &output);
+        // Дописывает вывод в конец строки
+        explicit OutputBuffer(std::string &output);
+        // Пишет вывод в файловый дескриптор, не закрывая его. При ошибке записи выбрасывает std::system_error
+        explicit OutputBuffer(int fd);
+
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        ~OutputBuffer();
+
+        void Put(char c)
+        {
+            if (pos_ == end_)
+            {
+                Drain();
+            }
+            *pos_++ = c;
+        }
+
+        void Write(std::string_view text)
+        {
+            if (text.size() > static_cast<size_t>(end_ - pos_))
+            {
+                WriteSlow(text);
+                return;
+            }
+            std::memcpy(pos_, text.data(), text.size());
+            pos_ += text.size();
+        }
+
+        void WriteInt(int64_t value);
+        void WriteUint(uint64_t value);
+        // Записывает кратчайшее представление, из которого value восстанавливается без потерь
+        void WriteDouble(double value);
+        // Записывает строку в кавычках, экранируя \, ", \r, \n и \t
+        void WriteString(std::string_view value);
+
+        void Flush();
+
+    private:
+        enum class SinkType
+        {
+            Stream,
+            String,
+            Descriptor,
+        };
+
+        // Гарантирует, что в буфере есть место под size символов
+        char *Reserve(size_t size)
+        {
+            if (static_cast<size_t>(end_ - pos_) < size)
+            {
+                Drain();
+            }
+            return pos_;
+        }
+
+        void WriteSlow(std::string_view text);
+        void Drain();
+        void WriteToSink(const char *data, size_t size);
+
+        SinkType sink_type_;
+        std::ostream *stream_ = nullptr;
+        std::string *string_ = nullptr;
+        int fd_ = -1;
+
+        std::unique_ptr<char[]> buffer_;
+        char *pos_;
+        char *end_;
+    };
+
+} // namespace json
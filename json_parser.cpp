@@ -0,0 +1,277 @@
+#include "json_parser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace json::detail
+{
+
+    namespace
+    {
+        bool IsDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        bool IsAlpha(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        // Проверяет, что число или литерал не продолжаются посторонними символами
+        ParseErrorCode CheckDelimiter(const char *cur, const char *end)
+        {
+            if (cur != end && !IsDelimiter(*cur))
+            {
+                return ParseErrorCode::UnexpectedCharacter;
+            }
+            return ParseErrorCode::Ok;
+        }
+
+        // Пропускает участок строки без кавычек, escape-последовательностей и переводов строки
+        const char *SkipPlainChars(const char *cur, const char *end)
+        {
+            while (true)
+            {
+                cur = FindStringSpecial(cur, end);
+                // Табуляция и другие управляющие символы, кроме переводов строки, допустимы внутри строки
+                if (cur == end || *cur == '"' || *cur == '\\' || *cur == '\n' || *cur == '\r')
+                {
+                    return cur;
+                }
+                ++cur;
+            }
+        }
+    } // namespace
+
+    ParseErrorCode ParseString(const char *&cur, const char *end, std::string &scratch, std::string_view &value)
+    {
+        // Строки без escape-последовательностей отдаём как участок исходного буфера
+        const char *begin = cur;
+        cur = SkipPlainChars(cur, end);
+        if (cur != end && *cur == '"')
+        {
+            value = std::string_view(begin, cur++ - begin);
+            return ParseErrorCode::Ok;
+        }
+
+        scratch.assign(begin, cur);
+        while (true)
+        {
+            if (cur == end)
+            {
+                // Поток закончился до того, как встретили закрывающую кавычку
+                return ParseErrorCode::UnterminatedString;
+            }
+            const char ch = *cur;
+            if (ch == '"')
+            {
+                // Встретили закрывающую кавычку
+                ++cur;
+                break;
+            }
+            else if (ch == '\\')
+            {
+                if (cur + 1 == end)
+                {
+                    // Поток завершился сразу после символа обратной косой черты
+                    return ParseErrorCode::UnterminatedString;
+                }
+                // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+                switch (cur[1])
+                {
+                case 'n':
+                    scratch.push_back('\n');
+                    break;
+                case 't':
+                    scratch.push_back('\t');
+                    break;
+                case 'r':
+                    scratch.push_back('\r');
+                    break;
+                case '"':
+                    scratch.push_back('"');
+                    break;
+                case '\\':
+                    scratch.push_back('\\');
+                    break;
+                default:
+                    // Встретили неизвестную escape-последовательность
+                    return ParseErrorCode::InvalidEscape;
+                }
+                cur += 2;
+            }
+            else
+            {
+                // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                return ParseErrorCode::NewlineInString;
+            }
+            // Участок без специальных символов копируем целиком
+            const char *run = cur;
+            cur = SkipPlainChars(cur, end);
+            scratch.append(run, cur);
+        }
+
+        value = scratch;
+        return ParseErrorCode::Ok;
+    }
+
+    ParseErrorCode ParseLiteral(const char *&cur, const char *end, Literal &value)
+    {
+        const char *begin = cur;
+        while (cur != end && IsAlpha(*cur))
+        {
+            ++cur;
+        }
+        const std::string_view word(begin, cur - begin);
+        if (word == "null"sv)
+        {
+            value = Literal::Null;
+        }
+        else if (word == "true"sv)
+        {
+            value = Literal::True;
+        }
+        else if (word == "false"sv)
+        {
+            value = Literal::False;
+        }
+        else
+        {
+            cur = begin;
+            return ParseErrorCode::InvalidLiteral;
+        }
+        return CheckDelimiter(cur, end);
+    }
+
+    ParseErrorCode ParseNumber(const char *&cur, const char *end, Number &value)
+    {
+        const char *begin = cur;
+
+        // Считывает одну или более цифр
+        auto read_digits = [&cur, end]
+        {
+            if (cur == end || !IsDigit(*cur))
+            {
+                return false;
+            }
+            while (cur != end && IsDigit(*cur))
+            {
+                ++cur;
+            }
+            return true;
+        };
+
+        if (*cur == '-')
+        {
+            ++cur;
+        }
+        // Парсим целую часть числа
+        if (cur != end && *cur == '0')
+        {
+            ++cur;
+            // После 0 в JSON не могут идти другие цифры
+        }
+        else if (!read_digits())
+        {
+            return ParseErrorCode::InvalidNumber;
+        }
+
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (cur != end && *cur == '.')
+        {
+            ++cur;
+            if (!read_digits())
+            {
+                return ParseErrorCode::InvalidNumber;
+            }
+            is_int = false;
+        }
+
+        // Парсим экспоненциальную часть числа
+        if (cur != end && (*cur == 'e' || *cur == 'E'))
+        {
+            ++cur;
+            if (cur != end && (*cur == '+' || *cur == '-'))
+            {
+                ++cur;
+            }
+            if (!read_digits())
+            {
+                return ParseErrorCode::InvalidNumber;
+            }
+            is_int = false;
+        }
+        if (const ParseErrorCode code = CheckDelimiter(cur, end); code != ParseErrorCode::Ok)
+        {
+            return code;
+        }
+
+        // Число разбирается на месте, без копирования цифр во временную строку
+        if (is_int)
+        {
+            int64_t int_value;
+            if (const auto [ptr, ec] = std::from_chars(begin, cur, int_value); ec == std::errc{})
+            {
+                if (int_value >= numeric_limits<int>::min() && int_value <= numeric_limits<int>::max())
+                {
+                    value = static_cast<int>(int_value);
+                }
+                else
+                {
+                    value = int_value;
+                }
+                return ParseErrorCode::Ok;
+            }
+            uint64_t uint_value;
+            if (const auto [ptr, ec] = std::from_chars(begin, cur, uint_value); ec == std::errc{})
+            {
+                value = uint_value;
+                return ParseErrorCode::Ok;
+            }
+            // Целые, не вмещающиеся в 64 бита, разбираются как double
+        }
+
+        double double_value;
+        if (const auto [ptr, ec] = std::from_chars(begin, cur, double_value); ec == std::errc{})
+        {
+            value = double_value;
+            return ParseErrorCode::Ok;
+        }
+        // from_chars не различает переполнение и потерю значимости. В этом редком случае
+        // разбираем число через strtod, который округляет слишком малые значения до нуля
+        const std::string parsed_num(begin, cur);
+        errno = 0;
+        double_value = std::strtod(parsed_num.c_str(), nullptr);
+        if (errno == ERANGE && std::abs(double_value) == HUGE_VAL)
+        {
+            cur = begin;
+            return ParseErrorCode::NumberOutOfRange;
+        }
+        value = double_value;
+        return ParseErrorCode::Ok;
+    }
+
+    ParseError MakeParseError(ParseErrorCode code, std::string_view input, size_t offset)
+    {
+        ParseError error{code, offset, 1, 1};
+        const char *cur = input.data();
+        const char *end = cur + std::min(offset, input.size());
+        while (const void *newline = std::memchr(cur, '\n', end - cur))
+        {
+            ++error.line;
+            cur = static_cast<const char *>(newline) + 1;
+        }
+        error.column = static_cast<size_t>(end - cur) + 1;
+        return error;
+    }
+
+} // namespace json::detail
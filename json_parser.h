@@ -0,0 +1,432 @@
+#pragma once
+
+#include "json.h"
+#include "json_index.h"
+
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace json::detail
+{
+
+    // Символы, на которых заканчиваются числа и литералы
+    inline bool IsDelimiter(char c)
+    {
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case ',':
+        case ':':
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case '"':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Функции ниже при ошибке возвращают её код, оставляя cur на ошибочном символе
+
+    // Считывает содержимое строкового литерала, cur указывает на символ после открывающей кавычки.
+    // Если в строке нет escape-последовательностей, в value записывается участок исходного буфера,
+    // иначе строка раскодируется в scratch. После вызова cur указывает за закрывающую кавычку
+    ParseErrorCode ParseString(const char *&cur, const char *end, std::string &scratch, std::string_view &value);
+
+    // Целое хранится в самом узком из int, int64_t и uint64_t, вмещающем значение,
+    // остальные числа — в double
+    using Number = std::variant<int, int64_t, uint64_t, double>;
+
+    // Считывает число, начинающееся в cur
+    ParseErrorCode ParseNumber(const char *&cur, const char *end, Number &value);
+
+    enum class Literal
+    {
+        Null,
+        True,
+        False,
+    };
+
+    // Считывает null, true или false, начинающиеся в cur
+    ParseErrorCode ParseLiteral(const char *&cur, const char *end, Literal &value);
+
+    // Дополняет код и смещение ошибки номером строки и столбца
+    ParseError MakeParseError(ParseErrorCode code, std::string_view input, size_t offset);
+
+    // Буферы разбора, которые можно переиспользовать между документами
+    struct ParserContext
+    {
+        TokenCursor tokens;
+        std::string scratch;
+        // Открытые контейнеры: true для массива, false для словаря
+        std::vector<bool> stack;
+        size_t max_depth = ParseOptions::kDefaultMaxDepth;
+    };
+
+    // Истина, если обработчик умеет отказываться от значений методом bool SkipValue()
+    template <typename Handler, typename = void>
+    struct CanSkipValues : std::false_type
+    {
+    };
+
+    template <typename Handler>
+    struct CanSkipValues<Handler, std::void_t<decltype(std::declval<Handler &>().SkipValue())>> : std::true_type
+    {
+    };
+
+    // Проверяет грамматику JSON-документа и сообщает обработчику о каждом значении.
+    // Handler должен предоставлять методы
+    //   OnNull(), OnBool(bool), OnInt(int), OnInt64(int64_t), OnUint64(uint64_t), OnDouble(double),
+    //   OnString(std::string_view),
+    //   OnKey(std::string_view), OnStartArray(), OnEndArray(), OnStartObject(), OnEndObject().
+    // Строки, переданные в OnString и OnKey, действительны только до возврата из метода.
+    // Если обработчик определяет bool SkipValue(), метод вызывается перед каждым значением,
+    // и при ответе true значение пропускается без событий и без проверки чего-либо, кроме парности скобок.
+    // Ошибки разбора не выбрасываются: методы разбора возвращают false, а ошибка запоминается
+    template <typename Handler>
+    class Parser
+    {
+    public:
+        Parser(std::string_view input, Handler &handler, ParserContext &context)
+            : input_(input), end_(input.data() + input.size()), tokens_(context.tokens), handler_(handler), scratch_(context.scratch),
+              stack_(context.stack), max_depth_(context.max_depth)
+        {
+            tokens_.Reset(input);
+        }
+
+        // Разбор идёт в цикле по явному стеку открытых контейнеров, а не рекурсией,
+        // поэтому расход стека потока не зависит от вложенности документа
+        bool ParseDocument()
+        {
+            stack_.clear();
+            skip_from_ = kNotSkipping;
+            const char *token;
+            if (!NextToken(token))
+            {
+                return false;
+            }
+            while (true)
+            {
+                // token указывает на начало значения
+                const size_t depth = stack_.size();
+                if (!ParseValue(token))
+                {
+                    return false;
+                }
+                if (stack_.empty())
+                {
+                    break;
+                }
+                if (!NextToken(token))
+                {
+                    return false;
+                }
+                if (stack_.size() > depth && *token != Closer())
+                {
+                    // Первый элемент только что открытого контейнера
+                    if (!StartItem(token))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                // Закрываем контейнеры, на последнем элементе которых закончилось значение
+                while (*token == Closer())
+                {
+                    EndContainer();
+                    if (stack_.empty())
+                    {
+                        break;
+                    }
+                    if (!NextToken(token))
+                    {
+                        return false;
+                    }
+                }
+                if (stack_.empty())
+                {
+                    break;
+                }
+                if (*token != ',')
+                {
+                    return Fail(stack_.back() ? ParseErrorCode::CommaOrBracketExpected : ParseErrorCode::CommaOrBraceExpected, token);
+                }
+                if (!NextToken(token) || !StartItem(token))
+                {
+                    return false;
+                }
+            }
+            if (const char *extra = tokens_.Next(); extra != nullptr)
+            {
+                return Fail(ParseErrorCode::TrailingData, extra);
+            }
+            return true;
+        }
+
+        ParseError GetError() const
+        {
+            return MakeParseError(error_code_, input_, error_offset_);
+        }
+
+    private:
+        bool Fail(ParseErrorCode code, const char *position)
+        {
+            error_code_ = code;
+            error_offset_ = static_cast<size_t>(position - input_.data());
+            return false;
+        }
+
+        bool Check(ParseErrorCode code, const char *position)
+        {
+            return code == ParseErrorCode::Ok || Fail(code, position);
+        }
+
+        // Записывает в token указатель на первый символ очередного токена
+        bool NextToken(const char *&token)
+        {
+            token = tokens_.Next();
+            return token != nullptr || Fail(ParseErrorCode::UnexpectedEnd, end_);
+        }
+
+        bool ParseValue(const char *token)
+        {
+            if constexpr (CanSkipValues<Handler>::value)
+            {
+                if (!Skipping() && handler_.SkipValue())
+                {
+                    skip_from_ = stack_.size();
+                }
+            }
+
+            const char c = *token;
+
+            if (c == '[' || c == '{')
+            {
+                if (stack_.size() >= max_depth_)
+                {
+                    return Fail(ParseErrorCode::DepthLimitExceeded, token);
+                }
+                const bool is_array = c == '[';
+                if (Skipping())
+                {
+                    // События пропускаемого значения не передаются
+                }
+                else if (is_array)
+                {
+                    handler_.OnStartArray();
+                }
+                else
+                {
+                    handler_.OnStartObject();
+                }
+                stack_.push_back(is_array);
+                return true;
+            }
+
+            if (c == '"')
+            {
+                ++token;
+                std::string_view value;
+                if (const ParseErrorCode code = ParseString(token, end_, scratch_, value); !Check(code, token))
+                {
+                    return false;
+                }
+                if (!Skipping())
+                {
+                    handler_.OnString(value);
+                }
+            }
+            else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            {
+                Literal literal;
+                if (const ParseErrorCode code = ParseLiteral(token, end_, literal); !Check(code, token))
+                {
+                    return false;
+                }
+                if (!Skipping())
+                {
+                    switch (literal)
+                    {
+                    case Literal::Null:
+                        handler_.OnNull();
+                        break;
+                    case Literal::True:
+                        handler_.OnBool(true);
+                        break;
+                    case Literal::False:
+                        handler_.OnBool(false);
+                        break;
+                    }
+                }
+            }
+            else if ((c >= '0' && c <= '9') || c == '-')
+            {
+                Number number;
+                if (const ParseErrorCode code = ParseNumber(token, end_, number); !Check(code, token))
+                {
+                    return false;
+                }
+                if (!Skipping())
+                {
+                    switch (number.index())
+                    {
+                    case 0:
+                        handler_.OnInt(std::get<int>(number));
+                        break;
+                    case 1:
+                        handler_.OnInt64(std::get<int64_t>(number));
+                        break;
+                    case 2:
+                        handler_.OnUint64(std::get<uint64_t>(number));
+                        break;
+                    default:
+                        handler_.OnDouble(std::get<double>(number));
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                return Fail(ParseErrorCode::UnexpectedToken, token);
+            }
+            EndSkipped();
+            return true;
+        }
+
+        // Истина, пока разбирается значение, от которого отказался обработчик. Пропускаемое
+        // значение проверяется целиком, чтобы проекция не меняла множество допустимых документов
+        bool Skipping() const
+        {
+            if constexpr (CanSkipValues<Handler>::value)
+            {
+                return skip_from_ != kNotSkipping;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        // Завершает пропуск, если только что закончилось само пропускаемое значение
+        void EndSkipped()
+        {
+            if (skip_from_ == stack_.size())
+            {
+                skip_from_ = kNotSkipping;
+            }
+        }
+
+        // Скобка, закрывающая текущий контейнер
+        char Closer() const
+        {
+            return stack_.back() ? ']' : '}';
+        }
+
+        void EndContainer()
+        {
+            if (Skipping())
+            {
+                stack_.pop_back();
+                EndSkipped();
+                return;
+            }
+            if (stack_.back())
+            {
+                handler_.OnEndArray();
+            }
+            else
+            {
+                handler_.OnEndObject();
+            }
+            stack_.pop_back();
+        }
+
+        // Начинает очередной элемент текущего контейнера с token. Для словаря разбирает ключ
+        // и двоеточие, оставляя в token начало значения
+        bool StartItem(const char *&token)
+        {
+            if (stack_.back())
+            {
+                return true;
+            }
+            if (*token != '"')
+            {
+                return Fail(ParseErrorCode::KeyExpected, token);
+            }
+            ++token;
+            std::string_view key;
+            if (const ParseErrorCode code = ParseString(token, end_, scratch_, key); !Check(code, token))
+            {
+                return false;
+            }
+            if (!Skipping())
+            {
+                handler_.OnKey(key);
+            }
+            if (!NextToken(token))
+            {
+                return false;
+            }
+            if (*token != ':')
+            {
+                return Fail(ParseErrorCode::ColonExpected, token);
+            }
+            return NextToken(token);
+        }
+
+        std::string_view input_;
+        const char *end_;
+        TokenCursor &tokens_;
+        Handler &handler_;
+        std::string &scratch_;
+        std::vector<bool> &stack_;
+        const size_t max_depth_;
+        // Глубина stack_, на которой началось пропускаемое значение
+        static constexpr size_t kNotSkipping = std::numeric_limits<size_t>::max();
+        size_t skip_from_ = kNotSkipping;
+        ParseErrorCode error_code_ = ParseErrorCode::Ok;
+        size_t error_offset_ = 0;
+    };
+
+    // Разбирает документ, не выбрасывая исключений при ошибках разбора
+    template <typename Handler>
+    std::optional<ParseError> TryParse(std::string_view input, Handler &handler, ParserContext &context)
+    {
+        Parser<Handler> parser(input, handler, context);
+        if (parser.ParseDocument())
+        {
+            return std::nullopt;
+        }
+        return parser.GetError();
+    }
+
+    // Разбирает документ, выбрасывая ParsingError при ошибке разбора
+    template <typename Handler>
+    void Parse(std::string_view input, Handler &handler, ParserContext &context)
+    {
+        if (const auto error = TryParse(input, handler, context))
+        {
+            throw ParsingError(error->ToString());
+        }
+    }
+
+    template <typename Handler>
+    void Parse(std::string_view input, Handler &handler)
+    {
+        ParserContext context;
+        Parse(input, handler, context);
+    }
+
+} // namespace json::detail
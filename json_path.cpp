@@ -0,0 +1,521 @@
+#include "json_path.h"
+#include "json_node_builder.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+using namespace std;
+
+namespace json
+{
+
+    namespace detail
+    {
+        std::vector<std::string> SplitPath(std::string_view path)
+        {
+            std::vector<std::string> segments;
+            if (path.empty())
+            {
+                return segments;
+            }
+            if (path.front() != '/')
+            {
+                throw std::invalid_argument("path must start with '/': "s + std::string(path));
+            }
+            for (size_t pos = 1;;)
+            {
+                const size_t slash = std::min(path.find('/', pos), path.size());
+                std::string &segment = segments.emplace_back();
+                for (size_t i = pos; i < slash; ++i)
+                {
+                    if (path[i] != '~')
+                    {
+                        segment.push_back(path[i]);
+                    }
+                    else if (i + 1 < slash && (path[i + 1] == '0' || path[i + 1] == '1'))
+                    {
+                        segment.push_back(path[++i] == '0' ? '~' : '/');
+                    }
+                    else
+                    {
+                        throw std::invalid_argument("invalid escape sequence in path: "s + std::string(path));
+                    }
+                }
+                if (slash == path.size())
+                {
+                    return segments;
+                }
+                pos = slash + 1;
+            }
+        }
+
+        namespace
+        {
+            // Номер элемента массива по RFC 6901: цифры без ведущих нулей
+            std::optional<size_t> ParseIndex(std::string_view segment)
+            {
+                if (segment.empty() || (segment.size() > 1 && segment.front() == '0'))
+                {
+                    return std::nullopt;
+                }
+                size_t index;
+                const auto [end, ec] = std::from_chars(segment.data(), segment.data() + segment.size(), index);
+                if (ec != std::errc{} || end != segment.data() + segment.size())
+                {
+                    return std::nullopt;
+                }
+                return index;
+            }
+
+            // Оставшаяся часть пути и номер пути
+            using Suffix = std::pair<std::vector<std::string_view>, size_t>;
+
+            PathStateId BuildState(std::vector<PathState> &tree, std::vector<Suffix> suffixes)
+            {
+                const PathStateId state = static_cast<PathStateId>(tree.size());
+                tree.emplace_back();
+
+                // Пути через «*» продолжаются и под каждым явно указанным ключом
+                std::vector<Suffix> any;
+                std::map<std::string_view, std::vector<Suffix>> by_key;
+                for (auto &[segments, id] : suffixes)
+                {
+                    if (segments.empty())
+                    {
+                        tree[state].matches.push_back(id);
+                        continue;
+                    }
+                    const std::string_view head = segments.front();
+                    segments.erase(segments.begin());
+                    (head == "*"sv ? any : by_key[head]).emplace_back(move(segments), id);
+                }
+                for (auto &[key, rest] : by_key)
+                {
+                    rest.insert(rest.end(), any.begin(), any.end());
+                    const PathStateId child = BuildState(tree, move(rest));
+                    tree[state].children.emplace(std::string(key), child);
+                    if (const auto index = ParseIndex(key))
+                    {
+                        tree[state].indices.emplace_back(*index, child);
+                    }
+                }
+                if (!any.empty())
+                {
+                    const PathStateId child = BuildState(tree, move(any));
+                    tree[state].any = child;
+                }
+                return state;
+            }
+        } // namespace
+
+        std::vector<PathState> BuildPathTree(const std::vector<std::vector<std::string>> &paths)
+        {
+            std::vector<Suffix> suffixes;
+            for (size_t id = 0; id < paths.size(); ++id)
+            {
+                suffixes.emplace_back(std::vector<std::string_view>(paths[id].begin(), paths[id].end()), id);
+            }
+            std::vector<PathState> tree;
+            BuildState(tree, move(suffixes));
+            return tree;
+        }
+
+        std::optional<PathStateId> StepPath(const std::vector<PathState> &tree, PathStateId parent, std::string_view key)
+        {
+            const PathState &state = tree[parent];
+            if (const auto it = state.children.find(key); it != state.children.end())
+            {
+                return it->second;
+            }
+            return state.any;
+        }
+    } // namespace detail
+
+    namespace
+    {
+        // Собирает дерево Node, пропуская значения, не лежащие на путях проекции
+        class ProjectingBuilder
+        {
+        public:
+            explicit ProjectingBuilder(const Projection &projection)
+                : projection_(projection)
+            {
+            }
+
+            bool SkipValue()
+            {
+                if (stack_.empty())
+                {
+                    state_ = projection_.GetRoot();
+                    return false;
+                }
+                Frame &frame = stack_.back();
+                if (projection_.IsSelected(frame.state))
+                {
+                    state_ = frame.state;
+                    return false;
+                }
+                std::optional<Projection::State> state;
+                if (frame.is_array)
+                {
+                    char buffer[24];
+                    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), frame.index++);
+                    state = projection_.Step(frame.state, std::string_view(buffer, end - buffer));
+                    if (!state)
+                    {
+                        ++frame.skipped;
+                        return true;
+                    }
+                }
+                else
+                {
+                    state = projection_.Step(frame.state, entries_.back().first);
+                    if (!state)
+                    {
+                        // Ключ пропущенного значения в словарь не попадает
+                        entries_.pop_back();
+                        return true;
+                    }
+                }
+                state_ = *state;
+                return false;
+            }
+
+            void OnNull() { AddScalar(nullptr); }
+            void OnBool(bool value) { AddScalar(value); }
+            void OnInt(int value) { AddScalar(value); }
+            void OnInt64(int64_t value) { AddScalar(value); }
+            void OnUint64(uint64_t value) { AddScalar(value); }
+            void OnDouble(double value) { AddScalar(value); }
+            void OnString(std::string_view value) { AddScalar(value); }
+
+            void OnKey(std::string_view key)
+            {
+                entries_.emplace_back(make_key_(key), Node());
+            }
+
+            void OnStartArray()
+            {
+                Frame &frame = stack_.emplace_back();
+                frame.is_array = true;
+                frame.state = state_;
+            }
+
+            void OnEndArray()
+            {
+                Node node(move(stack_.back().array));
+                stack_.pop_back();
+                AddValue(move(node));
+            }
+
+            void OnStartObject()
+            {
+                Frame &frame = stack_.emplace_back();
+                frame.is_array = false;
+                frame.state = state_;
+                frame.first_entry = entries_.size();
+            }
+
+            void OnEndObject()
+            {
+                // Словарь строится разом из накопленных пар, что дешевле поштучной вставки
+                const auto first = entries_.begin() + stack_.back().first_entry;
+                Node node(Dict(make_move_iterator(first), make_move_iterator(entries_.end())));
+                entries_.erase(first, entries_.end());
+                stack_.pop_back();
+                AddValue(move(node));
+            }
+
+            Node ExtractRoot()
+            {
+                return move(root_);
+            }
+
+        private:
+            struct Frame
+            {
+                bool is_array = false;
+                Projection::State state = 0;
+                Array array;
+                // Начало пар словаря в entries_
+                size_t first_entry = 0;
+                // Номер очередного элемента массива
+                size_t index = 0;
+                // Сколько пропущенных элементов массива ещё не заменено на null
+                size_t skipped = 0;
+            };
+
+            // Скаляр нужен, только если путь выбирает его целиком. Скаляр на месте, где путь
+            // продолжается вглубь (например, /user/id при "user": 5), отбрасывается, как и
+            // значение вне путей
+            template <typename T>
+            void AddScalar(T value)
+            {
+                if (projection_.IsSelected(state_))
+                {
+                    if constexpr (std::is_same_v<T, std::string_view>)
+                    {
+                        AddValue(Node(std::string(value)));
+                    }
+                    else
+                    {
+                        AddValue(Node(value));
+                    }
+                }
+                else if (!stack_.empty())
+                {
+                    if (Frame &frame = stack_.back(); frame.is_array)
+                    {
+                        ++frame.skipped;
+                    }
+                    else
+                    {
+                        entries_.pop_back();
+                    }
+                }
+            }
+
+            void AddValue(Node node)
+            {
+                if (stack_.empty())
+                {
+                    root_ = move(node);
+                }
+                else if (Frame &frame = stack_.back(); frame.is_array)
+                {
+                    frame.array.resize(frame.array.size() + frame.skipped);
+                    frame.skipped = 0;
+                    frame.array.push_back(move(node));
+                }
+                else
+                {
+                    entries_.back().second = move(node);
+                }
+            }
+
+            const Projection &projection_;
+            // Состояние значения, которое начинается сейчас
+            Projection::State state_ = 0;
+            std::vector<Frame> stack_;
+            std::vector<std::pair<Dict::key_type, Node>> entries_;
+            detail::KeyMaker make_key_;
+            Node root_;
+        };
+    } // namespace
+
+    Path::Path(std::string_view path)
+        : path_(path)
+    {
+        for (std::string &key : detail::SplitPath(path))
+        {
+            Segment &segment = segments_.emplace_back();
+            segment.any = key == "*"sv;
+            segment.index = detail::ParseIndex(key);
+            segment.key = move(key);
+        }
+    }
+
+    template <typename F>
+    bool Path::Walk(const Node &node, size_t depth, F &f) const
+    {
+        if (depth == segments_.size())
+        {
+            return f(node);
+        }
+        const Segment &segment = segments_[depth];
+        if (node.IsMap())
+        {
+            const Dict &dict = node.AsMap();
+            if (segment.any)
+            {
+                for (const auto &[key, child] : dict)
+                {
+                    if (!Walk(child, depth + 1, f))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else if (const auto it = dict.find(segment.key); it != dict.end())
+            {
+                return Walk(it->second, depth + 1, f);
+            }
+        }
+        else if (node.IsArray())
+        {
+            const Array &array = node.AsArray();
+            if (segment.any)
+            {
+                for (const Node &child : array)
+                {
+                    if (!Walk(child, depth + 1, f))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else if (segment.index && *segment.index < array.size())
+            {
+                return Walk(array[*segment.index], depth + 1, f);
+            }
+        }
+        return true;
+    }
+
+    const Node *Path::Find(const Node &root) const
+    {
+        const Node *found = nullptr;
+        auto take_first = [&found](const Node &node)
+        {
+            found = &node;
+            return false;
+        };
+        Walk(root, 0, take_first);
+        return found;
+    }
+
+    void Path::FindAll(const Node &root, std::vector<const Node *> &out) const
+    {
+        auto collect = [&out](const Node &node)
+        {
+            out.push_back(&node);
+            return true;
+        };
+        Walk(root, 0, collect);
+    }
+
+    namespace
+    {
+        std::vector<std::vector<std::string>> SegmentsOf(const std::vector<Path> &paths)
+        {
+            std::vector<std::vector<std::string>> result;
+            result.reserve(paths.size());
+            for (const Path &path : paths)
+            {
+                result.push_back(detail::SplitPath(path.ToString()));
+            }
+            return result;
+        }
+    } // namespace
+
+    PathSet::PathSet(const std::vector<Path> &paths)
+        : states_(detail::BuildPathTree(SegmentsOf(paths))), size_(paths.size())
+    {
+    }
+
+    void PathSet::Evaluate(const Node &root, std::vector<const Node *> &results) const
+    {
+        results.assign(size_, nullptr);
+        Walk(root, 0, results);
+    }
+
+    void PathSet::Walk(const Node &node, detail::PathStateId state_id, std::vector<const Node *> &results) const
+    {
+        const detail::PathState &state = states_[state_id];
+        for (size_t id : state.matches)
+        {
+            if (results[id] == nullptr)
+            {
+                results[id] = &node;
+            }
+        }
+        if (node.IsMap())
+        {
+            const Dict &dict = node.AsMap();
+            if (state.any)
+            {
+                // Нужны все ключи, поэтому обходим словарь целиком
+                for (const auto &[key, child] : dict)
+                {
+                    Walk(child, *detail::StepPath(states_, state_id, key), results);
+                }
+            }
+            else
+            {
+                for (const auto &[key, child_state] : state.children)
+                {
+                    if (const auto it = dict.find(key); it != dict.end())
+                    {
+                        Walk(it->second, child_state, results);
+                    }
+                }
+            }
+        }
+        else if (node.IsArray())
+        {
+            const Array &array = node.AsArray();
+            if (state.any)
+            {
+                for (size_t i = 0; i < array.size(); ++i)
+                {
+                    const auto it = std::find_if(state.indices.begin(), state.indices.end(), [i](const auto &item)
+                                                 { return item.first == i; });
+                    Walk(array[i], it != state.indices.end() ? it->second : *state.any, results);
+                }
+            }
+            else
+            {
+                for (const auto &[index, child_state] : state.indices)
+                {
+                    if (index < array.size())
+                    {
+                        Walk(array[index], child_state, results);
+                    }
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        std::vector<std::vector<std::string>> SplitPaths(const std::vector<std::string_view> &paths)
+        {
+            std::vector<std::vector<std::string>> result;
+            result.reserve(paths.size());
+            for (std::string_view path : paths)
+            {
+                result.push_back(detail::SplitPath(path));
+            }
+            return result;
+        }
+    } // namespace
+
+    Projection::Projection(std::initializer_list<std::string_view> paths)
+        : states_(detail::BuildPathTree(SplitPaths(paths)))
+    {
+    }
+
+    Projection::Projection(const std::vector<std::string> &paths)
+        : states_(detail::BuildPathTree(SplitPaths({paths.begin(), paths.end()})))
+    {
+    }
+
+    std::optional<Projection::State> Projection::Step(State parent, std::string_view key) const
+    {
+        // Внутри выбранного значения нужно всё
+        if (IsSelected(parent))
+        {
+            return parent;
+        }
+        return detail::StepPath(states_, parent, key);
+    }
+
+    Result<Document> TryLoad(std::string_view input, const Projection &projection)
+    {
+        detail::ParserContext context;
+        ProjectingBuilder builder(projection);
+        if (const auto error = detail::TryParse(input, builder, context))
+        {
+            return *error;
+        }
+        return Document{builder.ExtractRoot()};
+    }
+
+    Document Load(std::string_view input, const Projection &projection)
+    {
+        return TryLoad(input, projection).GetValue();
+    }
+
+} // namespace json
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+
+namespace json
+{
+
+    namespace detail
+    {
+        // Разбивает путь в формате JSON Pointer (RFC 6901) на сегменты, раскрывая ~0 и ~1.
+        // Пустой путь обозначает весь документ. При ошибке выбрасывает std::invalid_argument
+        std::vector<std::string> SplitPath(std::string_view path);
+
+        using PathStateId = uint32_t;
+
+        // Состояние дерева путей: какие пути закончились и куда ведёт следующий сегмент.
+        // Пути через «*» продолжены и под каждым явно указанным ключом, поэтому для значения
+        // достаточно одного состояния: явного перехода, а если его нет — перехода any
+        struct PathState
+        {
+            // Номера путей, которые заканчиваются в этом состоянии
+            std::vector<size_t> matches;
+            std::map<std::string, PathStateId, std::less<>> children;
+            // Те же переходы, что в children, для сегментов, являющихся номерами элементов массива
+            std::vector<std::pair<size_t, PathStateId>> indices;
+            std::optional<PathStateId> any;
+        };
+
+        // Строит дерево путей, состояние 0 соответствует корню документа
+        std::vector<PathState> BuildPathTree(const std::vector<std::vector<std::string>> &paths);
+
+        // Переход из состояния parent по ключу словаря или номеру элемента массива key
+        std::optional<PathStateId> StepPath(const std::vector<PathState> &tree, PathStateId parent, std::string_view key);
+    } // namespace detail
+
+    // Путь к значению в формате JSON Pointer, в котором сегмент «*» обозначает любой ключ
+    // словаря или любой элемент массива: /routes/0/handler, /items/*/price.
+    // Путь разбирается один раз при создании и затем применяется к любому количеству документов.
+    // Результаты — указатели на узлы документа, действительные, пока жив документ
+    class Path
+    {
+    public:
+        explicit Path(std::string_view path);
+
+        // Значение по пути или nullptr, если его нет. Для пути с «*» возвращает первое
+        // из подходящих значений в порядке обхода документа
+        const Node *Find(const Node &root) const;
+        // Дописывает в out все подходящие значения в порядке обхода документа
+        void FindAll(const Node &root, std::vector<const Node *> &out) const;
+
+        const std::string &ToString() const
+        {
+            return path_;
+        }
+
+    private:
+        friend class PathSet;
+
+        struct Segment
+        {
+            std::string key;
+            // Номер элемента массива, если сегмент состоит из цифр без ведущих нулей
+            std::optional<size_t> index;
+            bool any = false;
+        };
+
+        // Возвращает false, если поиск пора прекратить
+        template <typename F>
+        bool Walk(const Node &node, size_t depth, F &f) const;
+
+        std::string path_;
+        std::vector<Segment> segments_;
+    };
+
+    // Несколько путей, которые вычисляются за один обход документа
+    class PathSet
+    {
+    public:
+        explicit PathSet(const std::vector<Path> &paths);
+
+        // Заменяет содержимое results: results[i] — первое значение по i-му пути или nullptr
+        void Evaluate(const Node &root, std::vector<const Node *> &results) const;
+
+        size_t Size() const
+        {
+            return size_;
+        }
+
+    private:
+        void Walk(const Node &node, detail::PathStateId state, std::vector<const Node *> &results) const;
+
+        std::vector<detail::PathState> states_;
+        size_t size_;
+    };
+
+    // Набор путей к нужным значениям документа в том же формате, что и у Path.
+    // Пути компилируются в дерево, по которому разбор решает, нужно ли очередное значение
+    class Projection
+    {
+    public:
+        using State = detail::PathStateId;
+
+        Projection(std::initializer_list<std::string_view> paths);
+        explicit Projection(const std::vector<std::string> &paths);
+
+        // Состояние корня документа
+        State GetRoot() const
+        {
+            return 0;
+        }
+
+        // Состояние значения с ключом key (для массива — с номером элемента key) внутри значения
+        // в состоянии parent или std::nullopt, если значение не лежит ни на одном из путей
+        std::optional<State> Step(State parent, std::string_view key) const;
+
+        // Истина, если значение в этом состоянии нужно целиком
+        bool IsSelected(State state) const
+        {
+            return !states_[state].matches.empty();
+        }
+
+    private:
+        std::vector<detail::PathState> states_;
+    };
+
+    // Разбирает документ, оставляя в нём только значения, лежащие на путях projection,
+    // и контейнеры на пути к ним. Скаляр там, где путь ждёт контейнер, не попадает в документ,
+    // а корень из такого скаляра становится null. Остальные значения проверяются так же, как
+    // при полном разборе, но узлы для них не создаются, так что проекция принимает те же документы,
+    // что и Load. Пропущенные элементы массивов перед оставленными заменяются на null, чтобы номера
+    // элементов не менялись
+    Document Load(std::string_view input, const Projection &projection);
+    Result<Document> TryLoad(std::string_view input, const Projection &projection);
+
+} // namespace json
@@ -0,0 +1,286 @@
+#include "json_pmr.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+namespace json::pmr
+{
+
+    namespace
+    {
+        // Собирает дерево pmr::Node из событий detail::Parser, выделяя всю память из арены
+        class NodeBuilder
+        {
+        public:
+            explicit NodeBuilder(std::pmr::memory_resource *resource)
+                : resource_(resource)
+            {
+            }
+
+            void OnNull() { AddValue(nullptr); }
+            void OnBool(bool value) { AddValue(value); }
+            void OnInt(int value) { AddValue(value); }
+            void OnInt64(int64_t value) { AddValue(value); }
+            void OnUint64(uint64_t value) { AddValue(value); }
+            void OnDouble(double value) { AddValue(value); }
+            void OnString(std::string_view value) { AddValue(String(value, resource_)); }
+
+            void OnKey(std::string_view key)
+            {
+                stack_.back().key.assign(key);
+            }
+
+            void OnStartArray()
+            {
+                stack_.emplace_back(resource_).is_array = true;
+            }
+
+            void OnEndArray()
+            {
+                Array array(move(stack_.back().array));
+                stack_.pop_back();
+                AddValue(move(array));
+            }
+
+            void OnStartObject()
+            {
+                stack_.emplace_back(resource_).is_array = false;
+            }
+
+            void OnEndObject()
+            {
+                Dict dict(move(stack_.back().dict));
+                stack_.pop_back();
+                AddValue(move(dict));
+            }
+
+            Node ExtractRoot()
+            {
+                return move(root_);
+            }
+
+        private:
+            struct Frame
+            {
+                explicit Frame(std::pmr::memory_resource *resource)
+                    : array(resource), dict(resource), key(resource)
+                {
+                }
+
+                bool is_array = false;
+                Array array;
+                Dict dict;
+                String key;
+            };
+
+            // Узел создаётся сразу на своём месте, без перемещения из временного узла
+            template <typename T>
+            void AddValue(T &&value)
+            {
+                if (stack_.empty())
+                {
+                    root_ = Node(std::forward<T>(value));
+                }
+                else if (Frame &frame = stack_.back(); frame.is_array)
+                {
+                    frame.array.emplace_back(std::forward<T>(value));
+                }
+                else
+                {
+                    frame.dict.try_emplace(move(frame.key), std::forward<T>(value));
+                }
+            }
+
+            std::pmr::memory_resource *resource_;
+            std::vector<Frame> stack_;
+            Node root_;
+        };
+
+        // Размер первого блока арены. Дерево обычно занимает не меньше, чем исходный текст
+        constexpr size_t kMinInitialBlock = 4096;
+    } // namespace
+
+    const Node::Value &Node::GetValue() const
+    {
+        return value_;
+    }
+
+    // Node::Ctors
+    Node::Node(nullptr_t) : value_(nullptr) {}
+    Node::Node(Array array) : value_(move(array)) {}
+    Node::Node(Dict map) : value_(move(map)) {}
+    Node::Node(bool value) : value_(value) {}
+    Node::Node(int value) : value_(value) {}
+    Node::Node(int64_t value)
+    {
+        if (value >= numeric_limits<int>::min() && value <= numeric_limits<int>::max())
+        {
+            value_ = static_cast<int>(value);
+        }
+        else
+        {
+            value_ = value;
+        }
+    }
+    Node::Node(uint64_t value)
+    {
+        if (value <= static_cast<uint64_t>(numeric_limits<int64_t>::max()))
+        {
+            *this = Node(static_cast<int64_t>(value));
+        }
+        else
+        {
+            value_ = value;
+        }
+    }
+    Node::Node(double value) : value_(value) {}
+    Node::Node(String value) : value_(move(value)) {}
+
+    // Node::Is
+    bool Node::IsNull() const { return Is<nullptr_t>(); }
+    bool Node::IsArray() const { return Is<Array>(); }
+    bool Node::IsMap() const { return Is<Dict>(); }
+    bool Node::IsBool() const { return Is<bool>(); }
+    bool Node::IsInt() const { return Is<int>(); }
+    bool Node::IsInt64() const { return Is<int>() || Is<int64_t>(); }
+    bool Node::IsUint64() const { return Is<uint64_t>() || (IsInt64() && AsInt64() >= 0); }
+    bool Node::IsPureDouble() const { return Is<double>(); }
+    bool Node::IsDouble() const { return IsPureDouble() || IsInt64() || Is<uint64_t>(); }
+    bool Node::IsString() const { return Is<String>(); }
+
+    // Node::As
+    const Array &Node::AsArray() const { return ExtractValue<Array>(); }
+    const Dict &Node::AsMap() const { return ExtractValue<Dict>(); }
+    bool Node::AsBool() const { return ExtractValue<bool>(); }
+    int Node::AsInt() const { return ExtractValue<int>(); }
+    int64_t Node::AsInt64() const
+    {
+        if (Is<int>())
+        {
+            return AsInt();
+        }
+        return ExtractValue<int64_t>();
+    }
+    uint64_t Node::AsUint64() const
+    {
+        if (Is<uint64_t>())
+        {
+            return ExtractValue<uint64_t>();
+        }
+        if (!IsUint64())
+        {
+            throw(std::logic_error("value holds different type"));
+        }
+        return static_cast<uint64_t>(AsInt64());
+    }
+    double Node::AsDouble() const
+    {
+        if (IsInt64())
+        {
+            return static_cast<double>(AsInt64());
+        }
+        if (Is<uint64_t>())
+        {
+            return static_cast<double>(ExtractValue<uint64_t>());
+        }
+        return ExtractValue<double>();
+    }
+    const String &Node::AsString() const
+    {
+        return ExtractValue<String>();
+    }
+
+    bool operator==(const Node &lft, const Node &rgt)
+    {
+        return lft.GetValue() == rgt.GetValue();
+    }
+    bool operator!=(const Node &lft, const Node &rgt) { return !(lft == rgt); }
+
+    Document::Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena)
+        : arena_(move(arena))
+    {
+    }
+
+    Document::Document(Document &&other) noexcept
+        : arena_(move(other.arena_)), root_(exchange(other.root_, nullptr))
+    {
+    }
+
+    Document &Document::operator=(Document &&other) noexcept
+    {
+        if (this != &other)
+        {
+            arena_ = move(other.arena_);
+            root_ = exchange(other.root_, nullptr);
+        }
+        return *this;
+    }
+
+    const Node &Document::GetRoot() const
+    {
+        static const Node null_root;
+        return root_ ? *root_ : null_root;
+    }
+
+    std::pmr::memory_resource *Document::GetResource() const
+    {
+        return arena_.get();
+    }
+
+    Document Load(std::string_view input, std::pmr::memory_resource *upstream)
+    {
+        auto arena = make_unique<std::pmr::monotonic_buffer_resource>(std::max(input.size(), kMinInitialBlock), upstream);
+        Document doc(move(arena));
+
+        NodeBuilder builder(doc.GetResource());
+        detail::Parse(input, builder);
+
+        // Корень тоже лежит в арене, поэтому разрушать его при уничтожении документа не нужно
+        std::pmr::polymorphic_allocator<Node> alloc(doc.GetResource());
+        doc.root_ = alloc.allocate(1);
+        new (doc.root_) Node(builder.ExtractRoot());
+        return doc;
+    }
+
+    json::Node ToNode(const Node &node)
+    {
+        return visit(
+            [](const auto &value) -> json::Node
+            {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, Array>)
+                {
+                    json::Array result;
+                    result.reserve(value.size());
+                    for (const Node &item : value)
+                    {
+                        result.push_back(ToNode(item));
+                    }
+                    return result;
+                }
+                else if constexpr (std::is_same_v<T, Dict>)
+                {
+                    json::Dict result;
+                    for (const auto &[key, item] : value)
+                    {
+                        result.emplace_hint(result.end(), std::string(key), ToNode(item));
+                    }
+                    return result;
+                }
+                else if constexpr (std::is_same_v<T, String>)
+                {
+                    return std::string(value);
+                }
+                else
+                {
+                    return value;
+                }
+            },
+            node.GetValue());
+    }
+
+} // namespace json::pmr
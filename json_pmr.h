@@ -0,0 +1,112 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "json.h"
+
+// Вариант JSON-документа, все узлы, ключи и строки которого размещаются в арене документа
+namespace json::pmr
+{
+
+    class Node;
+    using Array = std::pmr::vector<Node>;
+    using Dict = std::pmr::map<std::pmr::string, Node, std::less<>>;
+    using String = std::pmr::string;
+
+    class Node
+    {
+    public:
+        using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, int64_t, uint64_t, double, String>;
+        const Value &GetValue() const;
+
+        Node() = default;
+        Node(std::nullptr_t);
+        Node(Array);
+        Node(Dict);
+        Node(bool);
+        Node(int);
+        // Как и в json::Node, целые хранятся в самом узком вмещающем их типе
+        Node(int64_t);
+        Node(uint64_t);
+        Node(double);
+        Node(String);
+
+        bool IsNull() const;
+        bool IsArray() const;
+        bool IsMap() const;
+        bool IsBool() const;
+        bool IsInt() const;
+        bool IsInt64() const;
+        bool IsUint64() const;
+        bool IsPureDouble() const;
+        bool IsDouble() const;
+        bool IsString() const;
+
+        const Array &AsArray() const;
+        const Dict &AsMap() const;
+        bool AsBool() const;
+        int AsInt() const;
+        int64_t AsInt64() const;
+        uint64_t AsUint64() const;
+        double AsDouble() const;
+        const String &AsString() const;
+
+    private:
+        template <typename T>
+        bool Is() const
+        {
+            return std::holds_alternative<T>(value_);
+        }
+
+        template <typename T>
+        const T &ExtractValue() const
+        {
+            if (!Is<T>())
+            {
+                throw(std::logic_error("value holds different type"));
+            }
+            return std::get<T>(value_);
+        }
+
+        Value value_;
+    };
+
+    bool operator==(const Node &lft, const Node &rgt);
+    bool operator!=(const Node &lft, const Node &rgt);
+
+    // Владеет ареной, в которой лежат все узлы документа. Деструкторы узлов не вызываются:
+    // память всех узлов освобождается одним вызовом при уничтожении арены
+    class Document
+    {
+    public:
+        // Документ, из которого переместили, остаётся пустым: его корень — null
+        Document(Document &&other) noexcept;
+        Document &operator=(Document &&other) noexcept;
+
+        const Node &GetRoot() const;
+
+        // Арена документа. Выделенная из неё память освобождается только вместе с документом
+        std::pmr::memory_resource *GetResource() const;
+
+    private:
+        friend Document Load(std::string_view input, std::pmr::memory_resource *upstream);
+
+        explicit Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena);
+
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        Node *root_ = nullptr;
+    };
+
+    // Разбирает документ, размещая его в новой арене. Блоки арены запрашиваются у upstream
+    Document Load(std::string_view input, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+    // Копирует узел в обычное дерево json::Node
+    json::Node ToNode(const Node &node);
+
+} // namespace json::pmr
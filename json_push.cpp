@@ -0,0 +1,71 @@
+#include "json_push.h"
+#include "json_node_builder.h"
+
+#include <utility>
+
+namespace json
+{
+
+    struct PushParser::Impl
+    {
+        explicit Impl(const ParseOptions &options)
+            : make_key(options.key_table), builder(make_key), parser(builder, options.max_depth)
+        {
+        }
+
+        detail::KeyMaker make_key;
+        detail::NodeBuilder builder;
+        detail::PushParser<detail::NodeBuilder> parser;
+    };
+
+    PushParser::PushParser()
+        : PushParser(ParseOptions{})
+    {
+    }
+
+    PushParser::PushParser(const ParseOptions &options)
+        : impl_(std::make_unique<Impl>(options))
+    {
+    }
+
+    PushParser::PushParser(PushParser &&) noexcept = default;
+    PushParser &PushParser::operator=(PushParser &&) noexcept = default;
+    PushParser::~PushParser() = default;
+
+    void PushParser::Feed(std::string_view chunk)
+    {
+        if (const auto error = TryFeed(chunk))
+        {
+            throw ParsingError(error->ToString());
+        }
+    }
+
+    std::optional<ParseError> PushParser::TryFeed(std::string_view chunk)
+    {
+        if (!impl_->parser.Feed(chunk))
+        {
+            return impl_->parser.GetError();
+        }
+        return std::nullopt;
+    }
+
+    Document PushParser::Finish()
+    {
+        return TryFinish().GetValue();
+    }
+
+    Result<Document> PushParser::TryFinish()
+    {
+        const bool is_complete = impl_->parser.Finish();
+        const ParseError error = impl_->parser.GetError();
+        impl_->parser.Reset();
+        if (!is_complete)
+        {
+            // Недостроенные контейнеры не должны попасть в следующий документ
+            impl_->builder = detail::NodeBuilder(impl_->make_key);
+            return error;
+        }
+        return Document{impl_->builder.ExtractRoot()};
+    }
+
+} // namespace json
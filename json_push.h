@@ -0,0 +1,463 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "json_parser.h"
+
+namespace json
+{
+
+    namespace detail
+    {
+        // Разбирает документ, поступающий частями произвольного размера, и сообщает обработчику
+        // о каждом значении так же, как detail::Parser (SkipValue не поддерживается).
+        // Между вызовами Feed хранится только стек открытых контейнеров и начало токена,
+        // разрезанного границей частей; токены, целиком лежащие в одной части, не копируются.
+        // Числа, литералы и строки разбираются теми же функциями, что и в detail::Parser,
+        // поэтому коды и позиции ошибок совпадают с разбором документа целиком
+        template <typename Handler>
+        class PushParser
+        {
+        public:
+            explicit PushParser(Handler &handler, size_t max_depth = ParseOptions::kDefaultMaxDepth)
+                : handler_(handler), max_depth_(max_depth)
+            {
+            }
+
+            // Разбирает очередную часть документа. Возвращает false при ошибке разбора,
+            // после которой остальные части не разбираются
+            bool Feed(std::string_view chunk)
+            {
+                if (error_code_ != ParseErrorCode::Ok)
+                {
+                    return false;
+                }
+                chunk_begin_ = chunk.data();
+                chunk_offset_ = offset_;
+                token_begin_ = chunk_begin_;
+                const char *cur = chunk.data();
+                const char *end = cur + chunk.size();
+                while (cur != end)
+                {
+                    if (token_ != Token::None)
+                    {
+                        if (!ContinueToken(cur, end))
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+                    const char c = *cur;
+                    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                    {
+                        if (c == '\n')
+                        {
+                            ++line_;
+                            line_start_ = Offset(cur) + 1;
+                        }
+                        ++cur;
+                    }
+                    else if (!ParseChar(cur))
+                    {
+                        return false;
+                    }
+                }
+                if (token_ != Token::None && pending_.empty())
+                {
+                    // Кавычка, открывающая строку, оказалась последним символом части
+                    pending_.append(token_begin_, end);
+                }
+                offset_ += chunk.size();
+                return true;
+            }
+
+            // Сообщает, что документ закончился. Возвращает false, если документ неполон или ошибочен
+            bool Finish()
+            {
+                if (error_code_ != ParseErrorCode::Ok)
+                {
+                    return false;
+                }
+                // Число или литерал в конце входа заканчиваются вместе с ним,
+                // а незакрытая строка даёт ту же ошибку, что и при разборе целиком
+                if (token_ != Token::None && !CompleteToken(pending_))
+                {
+                    return false;
+                }
+                if (expect_ != Expect::End)
+                {
+                    return Fail(ParseErrorCode::UnexpectedEnd, offset_);
+                }
+                return true;
+            }
+
+            ParseError GetError() const
+            {
+                return ParseError{error_code_, error_offset_, error_line_, error_offset_ - error_line_start_ + 1};
+            }
+
+            // Возвращает парсер в исходное состояние, сохраняя выделенную память
+            void Reset()
+            {
+                stack_.clear();
+                pending_.clear();
+                expect_ = Expect::Value;
+                token_ = Token::None;
+                escaped_ = false;
+                offset_ = 0;
+                line_ = 1;
+                line_start_ = 0;
+                error_code_ = ParseErrorCode::Ok;
+            }
+
+        private:
+            // Что может встретиться на месте очередного токена
+            enum class Expect : uint8_t
+            {
+                Value,
+                FirstItem,
+                FirstKey,
+                Key,
+                Colon,
+                CommaOrEnd,
+                End,
+            };
+
+            // Токен, который начался, но ещё не закончился
+            enum class Token : uint8_t
+            {
+                None,
+                String,
+                Key,
+                Scalar,
+            };
+
+            size_t Offset(const char *position) const
+            {
+                return chunk_offset_ + static_cast<size_t>(position - chunk_begin_);
+            }
+
+            bool Fail(ParseErrorCode code, size_t offset)
+            {
+                error_code_ = code;
+                error_offset_ = offset;
+                // Ошибки внутри токенов не переходят через перевод строки
+                error_line_ = line_;
+                error_line_start_ = line_start_;
+                return false;
+            }
+
+            // Разбирает структурный символ или начинает токен в cur
+            bool ParseChar(const char *&cur)
+            {
+                const char c = *cur;
+                switch (expect_)
+                {
+                case Expect::FirstItem:
+                    if (c == ']')
+                    {
+                        ++cur;
+                        return EndContainer();
+                    }
+                    return StartValue(cur);
+                case Expect::Value:
+                    return StartValue(cur);
+                case Expect::FirstKey:
+                    if (c == '}')
+                    {
+                        ++cur;
+                        return EndContainer();
+                    }
+                    [[fallthrough]];
+                case Expect::Key:
+                    if (c != '"')
+                    {
+                        return Fail(ParseErrorCode::KeyExpected, Offset(cur));
+                    }
+                    StartToken(Token::Key, cur);
+                    ++cur;
+                    return true;
+                case Expect::Colon:
+                    if (c != ':')
+                    {
+                        return Fail(ParseErrorCode::ColonExpected, Offset(cur));
+                    }
+                    expect_ = Expect::Value;
+                    ++cur;
+                    return true;
+                case Expect::CommaOrEnd:
+                {
+                    const bool is_array = stack_.back();
+                    if (c == ',')
+                    {
+                        expect_ = is_array ? Expect::Value : Expect::Key;
+                        ++cur;
+                        return true;
+                    }
+                    if (c == (is_array ? ']' : '}'))
+                    {
+                        ++cur;
+                        return EndContainer();
+                    }
+                    return Fail(is_array ? ParseErrorCode::CommaOrBracketExpected : ParseErrorCode::CommaOrBraceExpected, Offset(cur));
+                }
+                case Expect::End:
+                    break;
+                }
+                return Fail(ParseErrorCode::TrailingData, Offset(cur));
+            }
+
+            bool StartValue(const char *&cur)
+            {
+                const char c = *cur;
+                if (c == '[' || c == '{')
+                {
+                    if (stack_.size() >= max_depth_)
+                    {
+                        return Fail(ParseErrorCode::DepthLimitExceeded, Offset(cur));
+                    }
+                    const bool is_array = c == '[';
+                    if (is_array)
+                    {
+                        handler_.OnStartArray();
+                    }
+                    else
+                    {
+                        handler_.OnStartObject();
+                    }
+                    stack_.push_back(is_array);
+                    expect_ = is_array ? Expect::FirstItem : Expect::FirstKey;
+                    ++cur;
+                }
+                else if (c == '"')
+                {
+                    StartToken(Token::String, cur);
+                    ++cur;
+                }
+                else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-')
+                {
+                    StartToken(Token::Scalar, cur);
+                }
+                else
+                {
+                    return Fail(ParseErrorCode::UnexpectedToken, Offset(cur));
+                }
+                return true;
+            }
+
+            void StartToken(Token token, const char *begin)
+            {
+                token_ = token;
+                token_begin_ = begin;
+                token_offset_ = Offset(begin);
+                escaped_ = false;
+                pending_.clear();
+            }
+
+            // Ищет конец начатого токена. Если токен не закончился в этой части, запоминает его начало
+            bool ContinueToken(const char *&cur, const char *end)
+            {
+                bool is_complete = false;
+                if (token_ == Token::Scalar)
+                {
+                    while (cur != end && !IsDelimiter(*cur))
+                    {
+                        ++cur;
+                    }
+                    is_complete = cur != end;
+                }
+                else
+                {
+                    while (cur != end && !is_complete)
+                    {
+                        if (!escaped_)
+                        {
+                            // Обычные символы не меняют состояния, их пропускаем блоками
+                            cur = FindStringSpecial(cur, end);
+                            if (cur == end)
+                            {
+                                break;
+                            }
+                        }
+                        const char c = *cur++;
+                        // Перевод строки внутри строки — ошибка, о которой сообщит ParseString
+                        if (c == '\n' || c == '\r' || (c == '"' && !escaped_))
+                        {
+                            is_complete = true;
+                        }
+                        escaped_ = !escaped_ && c == '\\';
+                    }
+                }
+
+                if (!is_complete)
+                {
+                    pending_.append(token_begin_, cur);
+                    return true;
+                }
+                if (pending_.empty())
+                {
+                    return CompleteToken(std::string_view(token_begin_, cur - token_begin_));
+                }
+                pending_.append(token_begin_, cur);
+                return CompleteToken(pending_);
+            }
+
+            // Разбирает токен text целиком и передаёт его значение обработчику
+            bool CompleteToken(std::string_view text)
+            {
+                const Token token = token_;
+                token_ = Token::None;
+                const char *cur = text.data();
+                const char *end = cur + text.size();
+                const auto check = [this, &cur, &text](ParseErrorCode code)
+                {
+                    return code == ParseErrorCode::Ok || Fail(code, token_offset_ + static_cast<size_t>(cur - text.data()));
+                };
+
+                if (token != Token::Scalar)
+                {
+                    ++cur;
+                    std::string_view value;
+                    if (!check(ParseString(cur, end, scratch_, value)))
+                    {
+                        return false;
+                    }
+                    if (token == Token::Key)
+                    {
+                        handler_.OnKey(value);
+                        expect_ = Expect::Colon;
+                        return true;
+                    }
+                    handler_.OnString(value);
+                }
+                else if (const char c = *cur; (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                {
+                    Literal literal;
+                    if (!check(ParseLiteral(cur, end, literal)))
+                    {
+                        return false;
+                    }
+                    switch (literal)
+                    {
+                    case Literal::Null:
+                        handler_.OnNull();
+                        break;
+                    case Literal::True:
+                        handler_.OnBool(true);
+                        break;
+                    case Literal::False:
+                        handler_.OnBool(false);
+                        break;
+                    }
+                }
+                else
+                {
+                    Number number;
+                    if (!check(ParseNumber(cur, end, number)))
+                    {
+                        return false;
+                    }
+                    switch (number.index())
+                    {
+                    case 0:
+                        handler_.OnInt(std::get<int>(number));
+                        break;
+                    case 1:
+                        handler_.OnInt64(std::get<int64_t>(number));
+                        break;
+                    case 2:
+                        handler_.OnUint64(std::get<uint64_t>(number));
+                        break;
+                    default:
+                        handler_.OnDouble(std::get<double>(number));
+                        break;
+                    }
+                }
+                expect_ = stack_.empty() ? Expect::End : Expect::CommaOrEnd;
+                return true;
+            }
+
+            bool EndContainer()
+            {
+                if (stack_.back())
+                {
+                    handler_.OnEndArray();
+                }
+                else
+                {
+                    handler_.OnEndObject();
+                }
+                stack_.pop_back();
+                expect_ = stack_.empty() ? Expect::End : Expect::CommaOrEnd;
+                return true;
+            }
+
+            Handler &handler_;
+            const size_t max_depth_;
+            // Открытые контейнеры: true для массива, false для словаря
+            std::vector<bool> stack_;
+            Expect expect_ = Expect::Value;
+
+            Token token_ = Token::None;
+            // Начало токена в текущей части или начало части, если токен начался раньше
+            const char *token_begin_ = nullptr;
+            size_t token_offset_ = 0;
+            // Предыдущий символ строки — обратная косая черта, экранирующая следующий
+            bool escaped_ = false;
+            // Начало токена из предыдущих частей
+            std::string pending_;
+            std::string scratch_;
+
+            const char *chunk_begin_ = nullptr;
+            size_t chunk_offset_ = 0;
+            // Количество байт во всех разобранных частях
+            size_t offset_ = 0;
+            size_t line_ = 1;
+            size_t line_start_ = 0;
+
+            ParseErrorCode error_code_ = ParseErrorCode::Ok;
+            size_t error_offset_ = 0;
+            size_t error_line_ = 1;
+            size_t error_line_start_ = 0;
+        };
+    } // namespace detail
+
+    // Разбирает документ, поступающий частями, например из сокета, не дожидаясь его конца:
+    //   PushParser parser;
+    //   while (...) parser.Feed(chunk);
+    //   Document doc = parser.Finish();
+    // Части могут делить документ в любом месте, в том числе посреди строки или числа.
+    // Дерево строится по мере поступления частей, а сами части не накапливаются,
+    // поэтому после Feed буфер части можно переиспользовать
+    class PushParser
+    {
+    public:
+        PushParser();
+        explicit PushParser(const ParseOptions &options);
+        PushParser(PushParser &&) noexcept;
+        PushParser &operator=(PushParser &&) noexcept;
+        ~PushParser();
+
+        // При ошибке разбора выбрасывает ParsingError. Ошибка запоминается:
+        // следующие вызовы Feed и Finish выбрасывают её снова
+        void Feed(std::string_view chunk);
+        // Не выбрасывает исключений при ошибках разбора
+        std::optional<ParseError> TryFeed(std::string_view chunk);
+
+        // Завершает документ и возвращает его. После вызова парсер готов к разбору следующего
+        // документа, в том числе и после ошибки. При ошибке разбора выбрасывает ParsingError
+        Document Finish();
+        Result<Document> TryFinish();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace json
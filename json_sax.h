@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "json_parser.h"
+
+namespace json
+{
+
+    // Обработчик событий с пустыми методами. Наследник может переопределить только
+    // нужные ему методы: Parse вызывает их по статическому типу обработчика, без виртуальных вызовов
+    struct BaseHandler
+    {
+        void OnNull() {}
+        void OnBool(bool) {}
+        void OnInt(int) {}
+        void OnInt64(int64_t) {}
+        void OnUint64(uint64_t) {}
+        void OnDouble(double) {}
+        void OnString(std::string_view) {}
+        void OnKey(std::string_view) {}
+        void OnStartArray() {}
+        void OnEndArray() {}
+        void OnStartObject() {}
+        void OnEndObject() {}
+    };
+
+    // Разбирает документ, не строя дерево Node, и сообщает обработчику о каждом значении
+    // в порядке следования в документе. Ключ словаря передаётся в OnKey перед его значением.
+    // Строки, переданные в OnString и OnKey, действительны только до возврата из метода.
+    // При ошибке разбора выбрасывает ParsingError; события до места ошибки уже будут переданы.
+    // Разбор не рекурсивен, так что глубину вложенности ограничивает только options.max_depth
+    template <typename Handler>
+    void Parse(std::string_view input, Handler &handler, const ParseOptions &options = {})
+    {
+        detail::ParserContext context;
+        context.max_depth = options.max_depth;
+        detail::Parse(input, handler, context);
+    }
+
+    template <typename Handler>
+    void Parse(const char *data, size_t size, Handler &handler)
+    {
+        detail::Parse(std::string_view(data, size), handler);
+    }
+
+    // То же, что Parse, но вместо исключения возвращает описание ошибки разбора
+    template <typename Handler>
+    std::optional<ParseError> TryParse(std::string_view input, Handler &handler, const ParseOptions &options = {})
+    {
+        detail::ParserContext context;
+        context.max_depth = options.max_depth;
+        return detail::TryParse(input, handler, context);
+    }
+
+} // namespace json
@@ -0,0 +1,173 @@
+#include "json_writer.h"
+
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace json
+{
+
+    Writer::Writer(std::ostream &output)
+        : out_(output)
+    {
+    }
+
+    Writer::Writer(std::string &output)
+        : out_(output)
+    {
+    }
+
+    Writer::Writer(int fd)
+        : out_(fd)
+    {
+    }
+
+    void Writer::BeforeValue()
+    {
+        if (stack_.empty())
+        {
+            if (has_root_)
+            {
+                throw std::logic_error("the root value is already written");
+            }
+            has_root_ = true;
+            return;
+        }
+        Frame &frame = stack_.back();
+        if (!frame.is_array)
+        {
+            if (!has_key_)
+            {
+                throw std::logic_error("a key is expected before a dict value");
+            }
+            has_key_ = false;
+            return;
+        }
+        if (frame.has_items)
+        {
+            out_.Put(',');
+        }
+        frame.has_items = true;
+    }
+
+    void Writer::CheckContainer(bool is_array) const
+    {
+        if (stack_.empty() || stack_.back().is_array != is_array)
+        {
+            throw std::logic_error(is_array ? "no array to end" : "no dict to end");
+        }
+        if (has_key_)
+        {
+            throw std::logic_error("a value is expected after a key");
+        }
+    }
+
+    Writer &Writer::Null()
+    {
+        BeforeValue();
+        out_.Write("null"sv);
+        return *this;
+    }
+
+    Writer &Writer::Bool(bool value)
+    {
+        BeforeValue();
+        out_.Write(value ? "true"sv : "false"sv);
+        return *this;
+    }
+
+    Writer &Writer::Int(int64_t value)
+    {
+        BeforeValue();
+        out_.WriteInt(value);
+        return *this;
+    }
+
+    Writer &Writer::Uint(uint64_t value)
+    {
+        BeforeValue();
+        out_.WriteUint(value);
+        return *this;
+    }
+
+    Writer &Writer::Double(double value)
+    {
+        BeforeValue();
+        out_.WriteDouble(value);
+        return *this;
+    }
+
+    Writer &Writer::String(std::string_view value)
+    {
+        BeforeValue();
+        out_.WriteString(value);
+        return *this;
+    }
+
+    Writer &Writer::Value(const Node &value)
+    {
+        BeforeValue();
+        value.Visit(ValuePrinter{out_});
+        return *this;
+    }
+
+    Writer &Writer::StartArray()
+    {
+        BeforeValue();
+        out_.Put('[');
+        stack_.push_back({true, false});
+        return *this;
+    }
+
+    Writer &Writer::EndArray()
+    {
+        CheckContainer(true);
+        out_.Put(']');
+        stack_.pop_back();
+        return *this;
+    }
+
+    Writer &Writer::StartDict()
+    {
+        BeforeValue();
+        out_.Put('{');
+        stack_.push_back({false, false});
+        return *this;
+    }
+
+    Writer &Writer::Key(std::string_view key)
+    {
+        if (stack_.empty() || stack_.back().is_array)
+        {
+            throw std::logic_error("a key outside of a dict");
+        }
+        if (has_key_)
+        {
+            throw std::logic_error("a value is expected after a key");
+        }
+        Frame &frame = stack_.back();
+        if (frame.has_items)
+        {
+            out_.Put(',');
+        }
+        frame.has_items = true;
+        out_.WriteString(key);
+        out_.Put(':');
+        has_key_ = true;
+        return *this;
+    }
+
+    Writer &Writer::EndDict()
+    {
+        CheckContainer(false);
+        out_.Put('}');
+        stack_.pop_back();
+        return *this;
+    }
+
+    void Writer::Flush()
+    {
+        out_.Flush();
+    }
+
+} // namespace json
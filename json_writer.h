@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "json_output.h"
+
+namespace json
+{
+
+    // Пишет JSON прямо в поток, строку или файловый дескриптор по мере вызовов, не строя дерево:
+    //   writer.StartArray().Int(1).String("a"sv).EndArray();
+    // Вывод копится в OutputBuffer и уходит в приёмник крупными порциями, поэтому расход
+    // памяти не зависит от размера документа. Строки экранируются так же, как в Print.
+    // Вызов, нарушающий структуру документа, выбрасывает std::logic_error и ничего не пишет
+    class Writer
+    {
+    public:
+        explicit Writer(std::ostream &output);
+        // Дописывает вывод в конец строки
+        explicit Writer(std::string &output);
+        // Пишет в файловый дескриптор, не закрывая его. При ошибке записи выбрасывает std::system_error
+        explicit Writer(int fd);
+
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        Writer &Null();
+        Writer &Bool(bool value);
+        Writer &Int(int64_t value);
+        Writer &Uint(uint64_t value);
+        Writer &Double(double value);
+        Writer &String(std::string_view value);
+        // Поддерево целиком, как его напечатал бы Print
+        Writer &Value(const Node &value);
+
+        Writer &StartArray();
+        Writer &EndArray();
+
+        Writer &StartDict();
+        // Ключ следующего значения словаря
+        Writer &Key(std::string_view key);
+        Writer &EndDict();
+
+        // Истина, если корень записан и все контейнеры закрыты
+        bool IsComplete() const
+        {
+            return has_root_ && stack_.empty();
+        }
+
+        // Передаёт накопленный вывод в приёмник. Остаток передаётся и в деструкторе
+        void Flush();
+
+    private:
+        // Проверяет, что здесь допустимо значение, и пишет разделитель перед ним
+        void BeforeValue();
+        void CheckContainer(bool is_array) const;
+
+        // Незакрытый контейнер
+        struct Frame
+        {
+            bool is_array = false;
+            bool has_items = false;
+        };
+
+        OutputBuffer out_;
+        std::vector<Frame> stack_;
+        bool has_root_ = false;
+        // Ключ записан, и словарь ждёт его значения
+        bool has_key_ = false;
+    };
+
+} // namespace json
@@ -1,20 +1,585 @@
 #pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 #define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
 #define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
-#define LOG_DURATION(x) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
+
+// Замеряет время до конца текущей области видимости и добавляет его в статистику метки x
+// (std::string или строки, приводимой к нему). Области, вложенные одна в другую (в том числе
+// через вызовы функций), образуют дерево: статистика ведётся отдельно для каждого пути меток
+// от корня. Метка вычисляется при каждом входе, но в общей таблице под блокировкой ищется,
+// только когда отличается от предыдущей метки этого места в том же потоке: место замера
+// запоминает её в своей переменной thread_local. Поэтому постоянная метка, как и у
+// LOG_DURATION_STATIC, не требует блокировок, а к ним добавляется лишь сравнение строк.
+// LOG_DURATION_STATIC(x) принимает только строковый литерал и находит метку один раз,
+// поэтому замер стоит двух чтений часов и обновления счётчиков потока, без блокировок и вывода.
+// Оба макроса раскрываются в одно объявление.
+// Если определён макрос LOG_DURATION_DISABLED, макросы не порождают никакого кода
+#ifdef LOG_DURATION_DISABLED
+#define LOG_DURATION(x) static_cast<void>(0)
+#define LOG_DURATION_STATIC(x) static_cast<void>(0)
+#else
+#define LOG_DURATION(x) \
+    LogDuration UNIQUE_VAR_NAME_PROFILE([]() -> ::profile::detail::SiteCache & { thread_local ::profile::detail::SiteCache cache; return cache; }().Get(x))
+#define LOG_DURATION_STATIC(x) \
+    LogDuration UNIQUE_VAR_NAME_PROFILE([]() -> const ::profile::Site & { static const ::profile::Site site(x); return site; }())
+#endif
+
+namespace profile
+{
+
+    using SiteId = uint32_t;
+
+    // Статистика одного пути меток, собранная со всех потоков. Перцентили приближённые:
+    // длительности собираются в гистограмму с относительной точностью около 12%
+    struct Entry
+    {
+        // Метки от корня, разделённые «/»
+        std::string path;
+        std::string label;
+        size_t depth = 0;
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t min_ns = 0;
+        uint64_t max_ns = 0;
+        uint64_t p50_ns = 0;
+        uint64_t p90_ns = 0;
+        uint64_t p99_ns = 0;
+    };
+
+    enum class DumpFormat
+    {
+        Text,
+        Json,
+    };
+
+    namespace detail
+    {
+        // Гистограмма: по 4 корзины на каждую степень двойки наносекунд
+        constexpr size_t kSubBuckets = 4;
+        constexpr size_t kBuckets = 64 * kSubBuckets;
+
+        inline size_t BucketOf(uint64_t ns)
+        {
+            if (ns < kSubBuckets)
+            {
+                return static_cast<size_t>(ns);
+            }
+            const size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(ns));
+            return exponent * kSubBuckets + static_cast<size_t>((ns >> (exponent - 2)) & (kSubBuckets - 1));
+        }
+
+        // Наименьшее значение корзины. Значения меньше kSubBuckets учитываются точно, каждое
+        // в своей корзине, поэтому корзины степени 1 всегда пусты и начинаются с kSubBuckets
+        inline uint64_t BucketLowerBound(size_t bucket)
+        {
+            if (bucket < kSubBuckets)
+            {
+                return bucket;
+            }
+            const size_t exponent = bucket / kSubBuckets;
+            if (exponent < 2)
+            {
+                return kSubBuckets;
+            }
+            return (kSubBuckets + bucket % kSubBuckets) << (exponent - 2);
+        }
+
+        // Узел дерева областей одного потока. Счётчики меняет только поток-владелец,
+        // а Collect читает их из другого потока, поэтому они атомарные, но без
+        // атомарных операций чтения-записи: владельцу хватает обычных загрузок и сохранений
+        struct Node
+        {
+            Node(SiteId site, uint32_t parent)
+                : site(site), parent(parent)
+            {
+            }
+
+            void Record(uint64_t ns)
+            {
+                Add(count, 1);
+                Add(total_ns, ns);
+                if (ns < min_ns.load(std::memory_order_relaxed))
+                {
+                    min_ns.store(ns, std::memory_order_relaxed);
+                }
+                if (ns > max_ns.load(std::memory_order_relaxed))
+                {
+                    max_ns.store(ns, std::memory_order_relaxed);
+                }
+                Add(buckets[BucketOf(ns)], 1);
+            }
+
+            void Clear()
+            {
+                count.store(0, std::memory_order_relaxed);
+                total_ns.store(0, std::memory_order_relaxed);
+                min_ns.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+                max_ns.store(0, std::memory_order_relaxed);
+                for (auto &bucket : buckets)
+                {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+
+            static void Add(std::atomic<uint64_t> &counter, uint64_t value)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+
+            const SiteId site;
+            const uint32_t parent;
+            // Дочерние узлы: метка и номер узла
+            std::vector<std::pair<SiteId, uint32_t>> children;
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> total_ns{0};
+            std::atomic<uint64_t> min_ns{std::numeric_limits<uint64_t>::max()};
+            std::atomic<uint64_t> max_ns{0};
+            std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+        };
+
+        // Дерево областей потока. Узлы добавляет только владелец, под mutex,
+        // чтобы Collect из другого потока видел дерево целиком
+        class ThreadProfile
+        {
+        public:
+            ThreadProfile()
+            {
+                nodes_.emplace_back(std::numeric_limits<SiteId>::max(), 0);
+            }
+
+            // Входит в область с меткой site внутри текущей и возвращает её узел
+            uint32_t Enter(SiteId site)
+            {
+                Node &current = nodes_[current_];
+                for (const auto &[child_site, child] : current.children)
+                {
+                    if (child_site == site)
+                    {
+                        return current_ = child;
+                    }
+                }
+                std::lock_guard lock(mutex_);
+                const auto child = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back(site, current_);
+                current.children.emplace_back(site, child);
+                return current_ = child;
+            }
+
+            void Exit(uint32_t node, uint64_t ns)
+            {
+                nodes_[node].Record(ns);
+                current_ = nodes_[node].parent;
+            }
+
+            template <typename F>
+            void ForEachNode(F &&f)
+            {
+                std::lock_guard lock(mutex_);
+                for (size_t i = 1; i < nodes_.size(); ++i)
+                {
+                    f(nodes_, nodes_[i]);
+                }
+            }
+
+        private:
+            std::mutex mutex_;
+            // В deque узлы не перемещаются при добавлении новых
+            std::deque<Node> nodes_;
+            uint32_t current_ = 0;
+        };
+
+        // Статистика одного пути меток, сложенная из узлов разных потоков
+        struct Aggregate
+        {
+            void Add(const Node &node)
+            {
+                count += node.count.load(std::memory_order_relaxed);
+                total_ns += node.total_ns.load(std::memory_order_relaxed);
+                min_ns = std::min(min_ns, node.min_ns.load(std::memory_order_relaxed));
+                max_ns = std::max(max_ns, node.max_ns.load(std::memory_order_relaxed));
+                for (size_t i = 0; i < kBuckets; ++i)
+                {
+                    buckets[i] += node.buckets[i].load(std::memory_order_relaxed);
+                }
+            }
+
+            uint64_t count = 0;
+            uint64_t total_ns = 0;
+            uint64_t min_ns = std::numeric_limits<uint64_t>::max();
+            uint64_t max_ns = 0;
+            std::array<uint64_t, kBuckets> buckets{};
+        };
+
+        // Статистика по путям меток от корня
+        using Aggregates = std::map<std::vector<SiteId>, Aggregate>;
+
+        inline void AddProfile(ThreadProfile &profile, Aggregates &aggregates)
+        {
+            profile.ForEachNode([&aggregates](const std::deque<Node> &nodes, const Node &node)
+                                {
+                                    if (node.count.load(std::memory_order_relaxed) == 0)
+                                    {
+                                        return;
+                                    }
+                                    std::vector<SiteId> path;
+                                    for (const Node *cur = &node; cur != &nodes[0]; cur = &nodes[cur->parent])
+                                    {
+                                        path.push_back(cur->site);
+                                    }
+                                    std::reverse(path.begin(), path.end());
+                                    aggregates[path].Add(node); });
+        }
+
+        void DumpAtExit(DumpFormat format);
+
+        // Общие для всех потоков метки, профили работающих потоков и статистика завершившихся.
+        // Не разрушается, чтобы статистику можно было вывести при завершении программы
+        class Registry
+        {
+        public:
+            static Registry &Get()
+            {
+                static Registry *registry = []
+                {
+                    auto *created = new Registry();
+                    // LOG_DURATION_DUMP=text или json выводит статистику в std::cerr при завершении
+                    if (const char *dump = std::getenv("LOG_DURATION_DUMP"))
+                    {
+                        const std::string_view format = dump;
+                        if (format == "text" || format == "json")
+                        {
+                            DumpAtExit(format == "json" ? DumpFormat::Json : DumpFormat::Text);
+                        }
+                    }
+                    return created;
+                }();
+                return *registry;
+            }
+
+            SiteId Register(std::string_view label)
+            {
+                std::lock_guard lock(mutex_);
+                if (const auto it = ids_.find(label); it != ids_.end())
+                {
+                    return it->second;
+                }
+                const auto id = static_cast<SiteId>(labels_.size());
+                ids_.emplace(labels_.emplace_back(label), id);
+                return id;
+            }
+
+            void AddThread(ThreadProfile *profile)
+            {
+                std::lock_guard lock(mutex_);
+                threads_.push_back(profile);
+            }
+
+            // Переносит статистику завершающегося потока в общую, после чего профиль можно удалить
+            void RemoveThread(ThreadProfile *profile)
+            {
+                std::lock_guard lock(mutex_);
+                AddProfile(*profile, retired_);
+                threads_.erase(std::find(threads_.begin(), threads_.end(), profile));
+            }
+
+            // Статистика всех потоков вместе с метками
+            Aggregates Collect(std::vector<std::string> &labels)
+            {
+                std::lock_guard lock(mutex_);
+                Aggregates aggregates = retired_;
+                for (ThreadProfile *profile : threads_)
+                {
+                    AddProfile(*profile, aggregates);
+                }
+                labels.assign(labels_.begin(), labels_.end());
+                return aggregates;
+            }
+
+            void Reset()
+            {
+                std::lock_guard lock(mutex_);
+                retired_.clear();
+                for (ThreadProfile *profile : threads_)
+                {
+                    profile->ForEachNode([](const std::deque<Node> &, Node &node)
+                                         { node.Clear(); });
+                }
+            }
+
+        private:
+            Registry() = default;
+
+            std::mutex mutex_;
+            // Метки по номерам. Адреса строк в deque не меняются при добавлении новых
+            std::deque<std::string> labels_;
+            std::unordered_map<std::string_view, SiteId> ids_;
+            std::vector<ThreadProfile *> threads_;
+            Aggregates retired_;
+        };
+
+        // Профиль потока, который при завершении потока переносится в общую статистику
+        struct ThreadHandle
+        {
+            ThreadHandle()
+            {
+                Registry::Get().AddThread(&profile);
+            }
+
+            ~ThreadHandle()
+            {
+                Registry::Get().RemoveThread(&profile);
+            }
+
+            ThreadProfile profile;
+        };
+
+        inline ThreadProfile &CurrentThread()
+        {
+            thread_local ThreadHandle handle;
+            return handle.profile;
+        }
+
+        inline uint64_t Percentile(const std::array<uint64_t, kBuckets> &buckets, uint64_t count, double quantile)
+        {
+            const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(quantile * static_cast<double>(count) + 0.5));
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < kBuckets; ++bucket)
+            {
+                seen += buckets[bucket];
+                if (seen >= rank)
+                {
+                    if (bucket < kSubBuckets)
+                    {
+                        // Малые значения учтены точно
+                        return bucket;
+                    }
+                    // Середина корзины
+                    const uint64_t lower = BucketLowerBound(bucket);
+                    const uint64_t upper = bucket + 1 < kBuckets ? BucketLowerBound(bucket + 1) : lower;
+                    return lower + (upper - lower) / 2;
+                }
+            }
+            return 0;
+        }
+
+        inline void WriteJsonString(std::ostream &out, std::string_view text)
+        {
+            out << '"';
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out << escaped;
+                }
+                else
+                {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+    } // namespace detail
+
+    // Метка места замера. Места с одинаковой меткой учитываются вместе
+    class Site
+    {
+    public:
+        explicit Site(std::string_view label)
+            : id_(detail::Registry::Get().Register(label))
+        {
+        }
+
+        SiteId GetId() const
+        {
+            return id_;
+        }
+
+    private:
+        SiteId id_;
+    };
+
+    namespace detail
+    {
+        // Последняя метка места замера LOG_DURATION в одном потоке
+        class SiteCache
+        {
+        public:
+            const Site &Get(std::string_view label)
+            {
+                if (!site_ || label != label_)
+                {
+                    site_.emplace(label);
+                    label_.assign(label);
+                }
+                return *site_;
+            }
+
+        private:
+            std::string label_;
+            std::optional<Site> site_;
+        };
+    } // namespace detail
+
+    // Собирает статистику всех потоков, в том числе завершившихся. Пути упорядочены так,
+    // что каждая область следует сразу за областью, в которую вложена
+    inline std::vector<Entry> Collect()
+    {
+        std::vector<std::string> labels;
+        const detail::Aggregates aggregates = detail::Registry::Get().Collect(labels);
+
+        std::vector<Entry> entries;
+        entries.reserve(aggregates.size());
+        for (const auto &[path, aggregate] : aggregates)
+        {
+            Entry &entry = entries.emplace_back();
+            for (const SiteId site : path)
+            {
+                entry.label = labels[site];
+                entry.path += entry.path.empty() ? entry.label : "/" + entry.label;
+            }
+            entry.depth = path.size() - 1;
+            entry.count = aggregate.count;
+            entry.total_ns = aggregate.total_ns;
+            entry.min_ns = aggregate.min_ns;
+            entry.max_ns = aggregate.max_ns;
+            const auto percentile = [&aggregate = aggregate](double quantile)
+            {
+                return std::clamp(detail::Percentile(aggregate.buckets, aggregate.count, quantile), aggregate.min_ns, aggregate.max_ns);
+            };
+            entry.p50_ns = percentile(0.5);
+            entry.p90_ns = percentile(0.9);
+            entry.p99_ns = percentile(0.99);
+        }
+        return entries;
+    }
+
+    // Обнуляет статистику всех потоков
+    inline void Reset()
+    {
+        detail::Registry::Get().Reset();
+    }
+
+    // Выводит статистику таблицей (время в микросекундах) или одной строкой JSON
+    inline void Dump(std::ostream &out, DumpFormat format = DumpFormat::Text)
+    {
+        const std::vector<Entry> entries = Collect();
+        if (format == DumpFormat::Json)
+        {
+            out << '[';
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const Entry &entry = entries[i];
+                out << (i == 0 ? "{" : ",{") << "\"path\":";
+                detail::WriteJsonString(out, entry.path);
+                out << ",\"label\":";
+                detail::WriteJsonString(out, entry.label);
+                out << ",\"depth\":" << entry.depth << ",\"count\":" << entry.count << ",\"total_ns\":" << entry.total_ns
+                    << ",\"min_ns\":" << entry.min_ns << ",\"max_ns\":" << entry.max_ns << ",\"p50_ns\":" << entry.p50_ns
+                    << ",\"p90_ns\":" << entry.p90_ns << ",\"p99_ns\":" << entry.p99_ns << '}';
+            }
+            out << ']' << std::endl;
+            return;
+        }
+
+        const auto us = [](uint64_t ns)
+        {
+            return static_cast<double>(ns) / 1000;
+        };
+        const std::ios_base::fmtflags flags = out.flags();
+        out << std::left << std::setw(40) << "scope" << std::right << std::setw(10) << "count" << std::setw(14) << "total us"
+            << std::setw(12) << "avg us" << std::setw(12) << "min us" << std::setw(12) << "p50 us" << std::setw(12) << "p90 us"
+            << std::setw(12) << "p99 us" << std::setw(12) << "max us" << '\n';
+        out << std::fixed << std::setprecision(3);
+        for (const Entry &entry : entries)
+        {
+            out << std::left << std::setw(40) << std::string(entry.depth * 2, ' ') + entry.label << std::right
+                << std::setw(10) << entry.count << std::setw(14) << us(entry.total_ns)
+                << std::setw(12) << us(entry.total_ns) / static_cast<double>(entry.count) << std::setw(12) << us(entry.min_ns)
+                << std::setw(12) << us(entry.p50_ns) << std::setw(12) << us(entry.p90_ns) << std::setw(12) << us(entry.p99_ns)
+                << std::setw(12) << us(entry.max_ns) << '\n';
+        }
+        out.flush();
+        out.flags(flags);
+    }
+
+    namespace detail
+    {
+        inline std::atomic<DumpFormat> exit_dump_format{DumpFormat::Text};
+
+        inline void DumpAtExit(DumpFormat format)
+        {
+            static std::once_flag registered;
+            exit_dump_format = format;
+            std::call_once(registered, []
+                           { std::atexit([]
+                                         { Dump(std::cerr, exit_dump_format); }); });
+        }
+    } // namespace detail
+
+    // Выводит статистику в std::cerr при завершении программы
+    inline void DumpAtExit(DumpFormat format = DumpFormat::Text)
+    {
+        detail::DumpAtExit(format);
+    }
+
+} // namespace profile
+
+// Замеряет время жизни объекта и добавляет его в статистику метки site (см. LOG_DURATION)
 class LogDuration
 {
 public:
-using Clock = std::chrono::steady_clock;
-explicit LogDuration(const std::string &id)
-: id_(id)
-{}
-~LogDuration()
-{using namespace std::chrono; using namespace std::literals;const auto end_time = Clock::now();const auto dur = end_time - start_time_;std::cerr << id_ << " : "s << duration_cast<milliseconds>(dur).count() << " ms"s << std::endl;}
+    using Clock = std::chrono::steady_clock;
+
+    explicit LogDuration(const profile::Site &site)
+        : profile_(profile::detail::CurrentThread()), node_(profile_.Enter(site.GetId()))
+    {
+    }
+
+    explicit LogDuration(const std::string &label)
+        : LogDuration(profile::Site(label))
+    {
+    }
+
+    LogDuration(const LogDuration &) = delete;
+    LogDuration &operator=(const LogDuration &) = delete;
+
+    ~LogDuration()
+    {
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_);
+        profile_.Exit(node_, static_cast<uint64_t>(duration.count()));
+    }
+
 private:
-const std::string id_;
-const Clock::time_point start_time_ = Clock::now();
+    profile::detail::ThreadProfile &profile_;
+    const uint32_t node_;
+    // Отсчёт начинается после входа в узел, чтобы не учитывать его поиск
+    const Clock::time_point start_time_ = Clock::now();
 };
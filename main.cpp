@@ -1,9 +1,32 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <numeric>
 #include <sstream>
 #include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "json.h"
+#include "json_builder.h"
+#include "json_file.h"
+#include "json_index.h"
+#include "json_lazy.h"
+#include "json_lines.h"
+#include "json_path.h"
+#include "json_push.h"
+#include "json_pmr.h"
+#include "json_sax.h"
+#include "json_writer.h"
+#include "log_duration.h"
 
 using namespace json;
 using namespace std::literals;
@@ -145,6 +168,57 @@ namespace
     assert(LoadJSON(" \t\r\n\n\r 0.0 \t\r\n\n\r ").GetRoot() == Node{0.0});
   }
 
+  [[maybe_unused]] void TestInt64()
+  {
+    // Целые вне диапазона int не теряют точности
+    const Node id = LoadJSON("9007199254740993"s).GetRoot();
+    assert(id.IsInt64() && !id.IsInt());
+    assert(id.AsInt64() == 9007199254740993LL);
+    assert(id.IsUint64() && id.AsUint64() == 9007199254740993ULL);
+    assert(id.IsDouble() && !id.IsPureDouble());
+    assert(Print(id) == "9007199254740993"s);
+    MustThrowLogicError([&id]
+                        { id.AsInt(); });
+
+    const Node min = LoadJSON("-9223372036854775808"s).GetRoot();
+    assert(min.AsInt64() == std::numeric_limits<int64_t>::min());
+    assert(!min.IsUint64());
+    MustThrowLogicError([&min]
+                        { min.AsUint64(); });
+    assert(Print(min) == "-9223372036854775808"s);
+
+    const Node max = LoadJSON("18446744073709551615"s).GetRoot();
+    assert(max.IsUint64() && !max.IsInt64());
+    assert(max.AsUint64() == std::numeric_limits<uint64_t>::max());
+    assert(Print(max) == "18446744073709551615"s);
+
+    // Целые шире 64 бит становятся double
+    assert(LoadJSON("18446744073709551616"s).GetRoot().IsPureDouble());
+
+    // Целое хранится в самом узком вмещающем его типе
+    assert(Node{int64_t{42}} == Node{42});
+    assert(Node{int64_t{42}}.IsInt());
+    assert(Node{uint64_t{5000000000}} == Node{int64_t{5000000000}});
+    assert(Node{42}.IsInt64() && Node{42}.AsUint64() == 42u);
+    assert(!Node{-1}.IsUint64());
+
+    // Граничные случаи разбора чисел с плавающей запятой
+    assert(LoadJSON("1e-400"s).GetRoot().AsDouble() == 0.0);
+    assert(LoadJSON("-2.5E3"s).GetRoot().AsDouble() == -2500.0);
+    assert(LoadJSON("2147483648"s).GetRoot().AsInt64() == 2147483648LL);
+    assert(LoadJSON("-2147483648"s).GetRoot().IsInt());
+    MustFailToLoad("1e400"s);
+    MustFailToLoad("01"s);
+    MustFailToLoad("1."s);
+    MustFailToLoad("+1"s);
+
+    const json::pmr::Document pmr_doc = json::pmr::Load("[9007199254740993, 18446744073709551615]"sv);
+    const auto &items = pmr_doc.GetRoot().AsArray();
+    assert(items[0].AsInt64() == 9007199254740993LL);
+    assert(items[1].AsUint64() == std::numeric_limits<uint64_t>::max());
+    assert(json::pmr::ToNode(pmr_doc.GetRoot()) == (Node{Array{int64_t{9007199254740993}, std::numeric_limits<uint64_t>::max()}}));
+  }
+
   [[maybe_unused]] void TestStrings()
   {
     Node str_node{"Hello, \"everybody\""s};
@@ -261,34 +335,1412 @@ namespace
                         { array_node.AsBool(); });
   }
 
-  [[maybe_unused]] void Benchmark()
+  [[maybe_unused]] void TestLoadFromBuffer()
+  {
+    const std::string text = R"({"key": [1, 2.5, "str", true, null]})"s;
+    const Node expected{Dict{{"key"s, Array{1, 2.5, "str"s, true, nullptr}}}};
+    assert(json::Load(std::string_view{text}).GetRoot() == expected);
+    assert(json::Load(text.data(), text.size()).GetRoot() == expected);
+    // Буфер не обязан заканчиваться нулевым символом
+    assert(json::Load("[1,2]xyz", 5).GetRoot() == (Node{Array{1, 2}}));
+    assert(LoadJSON(text).GetRoot() == expected);
+
+    MustFailToLoad(""s);
+    MustFailToLoad("[1 2]"s);
+    MustFailToLoad("{\"a\" 1}"s);
+    MustFailToLoad("[1,]"s);
+    MustFailToLoad("1 2"s);
+  }
+
+  [[maybe_unused]] void TestTryLoad()
+  {
+    using json::ParseError;
+    using json::ParseErrorCode;
+
+    const auto error_of = [](std::string_view text)
+    {
+      const json::Result<Document> result = json::TryLoad(text);
+      assert(!result);
+      return result.GetError();
+    };
+
+    const json::Result<Document> ok = json::TryLoad("[1, 2]"sv);
+    assert(ok.HasValue());
+    assert(ok.GetValue().GetRoot() == (Node{Array{1, 2}}));
+    MustThrowLogicError([&ok]
+                        { ok.GetError(); });
+
+    {
+      const ParseError error = error_of("[1,\n 2 x]"sv);
+      assert(error.code == ParseErrorCode::CommaOrBracketExpected);
+      assert(error.offset == 7 && error.line == 2 && error.column == 4);
+      assert(error.ToString() == "',' or ']' is expected at line 2, column 4"s);
+    }
+    {
+      const ParseError error = error_of("{\"a\": \"abc"sv);
+      assert(error.code == ParseErrorCode::UnterminatedString);
+      assert(error.offset == 10 && error.line == 1 && error.column == 11);
+    }
+    assert(error_of(""sv).code == ParseErrorCode::UnexpectedEnd);
+    assert(error_of("[1] 2"sv).code == ParseErrorCode::TrailingData);
+    assert(error_of("{1: 2}"sv).code == ParseErrorCode::KeyExpected);
+    assert(error_of("{\"a\" 1}"sv).code == ParseErrorCode::ColonExpected);
+    assert(error_of("[\"\\q\"]"sv).code == ParseErrorCode::InvalidEscape);
+    assert(error_of("[nul]"sv).code == ParseErrorCode::InvalidLiteral);
+    assert(error_of("-x"sv).code == ParseErrorCode::InvalidNumber);
+    assert(error_of("1e999"sv).code == ParseErrorCode::NumberOutOfRange);
+    assert(error_of("[12a]"sv).code == ParseErrorCode::UnexpectedCharacter);
+
+    // Loader после ошибки разбирает следующий документ с чистого листа
+    json::Loader loader;
+    assert(!loader.TryLoad("{\"a\": [1, "sv));
+    assert(loader.TryLoad("[3]"sv).GetValue().GetRoot() == (Node{Array{3}}));
+
+    // Обращение к значению ошибочного результата выбрасывает ParsingError
+    try
+    {
+      json::TryLoad("[1,"sv).GetValue();
+      assert(false);
+    }
+    catch (const json::ParsingError &e)
+    {
+      assert(e.what() == "Unexpected end of input at line 1, column 4"s);
+    }
+
+    json::BaseHandler handler;
+    assert(!json::TryParse("[1, 2]"sv, handler));
+    assert(json::TryParse("[1, 2"sv, handler)->code == ParseErrorCode::UnexpectedEnd);
+  }
+
+  [[maybe_unused]] void TestPushParser()
   {
-    const auto start = std::chrono::steady_clock::now();
+    using json::ParseError;
+
+    const std::string text = "{\"name\": \"a\\\"b\\\\\", \"list\": [1, -20, 3.5e2, 12345678901, 18446744073709551615],\n"
+                             " \"flags\": [true, false, null], \"nested\": {\"empty\": [], \"obj\": {}}, \"s\": \"\"}"s;
+    const Node expected = json::Load(text).GetRoot();
+
+    // Документ, разрезанный в любом месте, разбирается так же, как целиком
+    PushParser parser;
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+      parser.Feed(std::string_view(text).substr(0, split));
+      parser.Feed(std::string_view(text).substr(split));
+      assert(parser.Finish().GetRoot() == expected);
+    }
+    for (const char c : text)
+    {
+      parser.Feed(std::string_view(&c, 1));
+    }
+    assert(parser.Finish().GetRoot() == expected);
+
+    // Число в корне документа заканчивается вместе с входом
+    parser.Feed("4"sv);
+    parser.Feed("2 "sv);
+    assert(parser.Finish().GetRoot() == Node{42});
+
+    // Ошибки совпадают с ошибками разбора целиком при любой нарезке входа
+    for (const std::string_view broken : {""sv, "[1,\n 2 x]"sv, "{\"a\": \"abc"sv, "[1] 2"sv, "{1: 2}"sv, "{\"a\" 1}"sv,
+                                          "[\"\\q\"]"sv, "[nul]"sv, "-x"sv, "1e999"sv, "[12a]"sv, "[\"a\nb\"]"sv, "[1,]"sv})
+    {
+      const ParseError error = json::TryLoad(broken).GetError();
+      for (const size_t chunk_size : {size_t{1}, size_t{3}, broken.size() + 1})
+      {
+        std::optional<ParseError> feed_error;
+        for (size_t pos = 0; pos < broken.size() && !feed_error; pos += chunk_size)
+        {
+          feed_error = parser.TryFeed(broken.substr(pos, chunk_size));
+        }
+        const json::Result<Document> result = parser.TryFinish();
+        assert(!result);
+        const ParseError push_error = result.GetError();
+        assert(!feed_error || feed_error->code == push_error.code);
+        assert(push_error.code == error.code && push_error.offset == error.offset);
+        assert(push_error.line == error.line && push_error.column == error.column);
+      }
+    }
+
+    // После ошибки Feed выбрасывает её снова, а Finish начинает следующий документ
+    try
+    {
+      parser.Feed("[1 2"sv);
+      assert(false);
+    }
+    catch (const ParsingError &)
+    {
+    }
+    assert(parser.TryFeed("]"sv)->code == json::ParseErrorCode::CommaOrBracketExpected);
+    assert(!parser.TryFinish());
+    parser.Feed("[\"ok\"]"sv);
+    assert(parser.Finish().GetRoot() == (Node{Array{"ok"s}}));
+  }
+
+  [[maybe_unused]] void TestDepthLimit()
+  {
+    const auto nested = [](size_t depth)
+    {
+      return std::string(depth, '[') + std::string(depth, ']');
+    };
+    const size_t limit = json::ParseOptions::kDefaultMaxDepth;
+
+    assert(json::Load(nested(limit)).GetRoot().IsArray());
+    const json::ParseError error = json::TryLoad(nested(limit + 1)).GetError();
+    assert(error.code == json::ParseErrorCode::DepthLimitExceeded && error.offset == limit);
+    assert(error.ToString() == "Maximum nesting depth is exceeded at line 1, column "s + std::to_string(limit + 1));
+
+    // Ограничение настраивается, а вложенность в нём не расходует стек потока
+    json::Loader strict(json::ParseOptions{2});
+    assert(strict.TryLoad("[{\"a\": 1}, []]"sv));
+    assert(strict.TryLoad("{\"a\": [[1]]}"sv).GetError().code == json::ParseErrorCode::DepthLimitExceeded);
+    json::Loader deep(json::ParseOptions{20000});
+    assert(deep.Load(nested(20000)).GetRoot().AsArray().size() == 1);
+
+    struct DepthHandler : json::BaseHandler
+    {
+      size_t depth = 0;
+      size_t max_depth = 0;
+      void OnStartArray() { max_depth = std::max(max_depth, ++depth); }
+      void OnEndArray() { --depth; }
+    } handler;
+    json::Parse(nested(1000000), handler, json::ParseOptions{std::numeric_limits<size_t>::max()});
+    assert(handler.max_depth == 1000000 && handler.depth == 0);
+
+    PushParser push(json::ParseOptions{3});
+    push.Feed("[[[1]], "sv);
+    assert(push.TryFeed("[[[]]]]"sv)->offset == 10);
+    assert(!push.TryFinish());
+  }
+
+  [[maybe_unused]] void TestLazyDocument()
+  {
+    const std::string text = R"({"id": 9007199254740993, "name": "a\"b", "tags": ["x", "y"], "meta": {"ok": true, "none": null}, "pi": 3.5, "empty": [], "id": 1})"s;
+    const json::LazyDocument doc = json::LoadLazy(text);
+    const json::LazyNode root = doc.GetRoot();
+    assert(root.IsMap() && !root.IsArray());
+    assert(root.Size() == 7);
+
+    // Из повторяющихся ключей, как и при полном разборе, действует первый
+    assert(root.At("id"sv).AsInt64() == 9007199254740993LL);
+    assert(root.At("name"sv).IsString());
+    assert(root.At("name"sv).AsString() == "a\"b"s);
+    // Собранное значение запоминается в документе
+    assert(&root.At("name"sv).AsString() == &root.At("name"sv).AsString());
+    assert(root.At("tags"sv).Size() == 2);
+    assert(root.At("tags"sv).At(1).AsString() == "y"s);
+    assert(root.At("meta"sv).At("ok"sv).AsBool());
+    assert(root.At("meta"sv).At("none"sv).IsNull());
+    assert(root.At("pi"sv).IsPureDouble() && root.At("pi"sv).AsDouble() == 3.5);
+    assert(root.At("empty"sv).Size() == 0);
+    assert(!root.Find("missing"sv));
+    assert(root.At("tags"sv).AsArray() == (Array{"x"s, "y"s}));
+    assert(root.At("meta"sv).AsMap() == (Dict{{"ok"s, true}, {"none"s, nullptr}}));
+
+    // Полное дерево совпадает с результатом обычного разбора
+    assert(root.Materialize() == json::Load(text).GetRoot());
+
+    // Числовые предикаты не выбрасывают исключений для строк, контейнеров и литералов
+    for (const std::string_view key : {"name"sv, "tags"sv, "meta"sv, "empty"sv})
+    {
+      const json::LazyNode node = root.At(key);
+      assert(!node.IsInt() && !node.IsInt64() && !node.IsUint64() && !node.IsPureDouble() && !node.IsDouble());
+    }
+    assert(!root.IsInt() && !root.IsDouble());
+    assert(!root.At("meta"sv).At("ok"sv).IsInt() && !root.At("meta"sv).At("none"sv).IsDouble());
+    assert(root.At("id"sv).IsInt64() && root.At("id"sv).IsDouble() && !root.At("id"sv).IsInt());
+
+    // Индекс строится окнами, поэтому длинные токены не мешают найти следующие за ними
+    const std::string long_text = "[\""s + std::string(1 << 20, 'x') + "\", 1, 2]"s;
+    {
+      const json::LazyDocument long_doc = json::LoadLazy(long_text);
+      assert(long_doc.GetRoot().Size() == 3);
+      assert(long_doc.GetRoot().At(2).AsInt() == 2);
+    }
+
+    try
+    {
+      root.At("missing"sv);
+      assert(false);
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+    try
+    {
+      root.At("tags"sv).At(2);
+      assert(false);
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+    MustThrowLogicError([&root]
+                        { root.At("pi"sv).AsInt(); });
+    MustThrowLogicError([&root]
+                        { root.At("name"sv).AsArray(); });
+    MustThrowLogicError([&root]
+                        { root.At(size_t{0}); });
+
+    assert(json::LoadLazy("42"sv).GetRoot().AsInt() == 42);
+    // Вход проверяется целиком ещё до обращения к значениям
+    const auto error = json::TryLoadLazy(R"({"a": [1, 2}, "b": 3})"sv);
+    assert(!error && error.GetError().code == json::ParseErrorCode::CommaOrBracketExpected);
+    assert(!json::TryLoadLazy(R"({"a": tru})"sv));
+    // Слишком длинный вход отвергается до чтения, поэтому байты за пределами буфера не нужны
+    if constexpr (sizeof(size_t) > sizeof(uint32_t))
+    {
+      const char small[] = "[]";
+      const auto too_large = json::TryLoadLazy(std::string_view(small, size_t{std::numeric_limits<uint32_t>::max()} + 1));
+      assert(!too_large && too_large.GetError().code == json::ParseErrorCode::InputTooLarge);
+      assert(too_large.GetError().Message() == "Input is too large"s);
+    }
+  }
+
+  [[maybe_unused]] void TestProjection()
+  {
+    const auto text = R"({
+      "user": {"id": 7, "name": "Ann", "roles": ["a", "b"]},
+      "items": [{"price": 1.5, "title": "x"}, {"title": "y"}, {"price": 3, "extra": {"deep": [1, {"z": null}]}}],
+      "big": {"nested": [[[]], {"a": "}]"}], "more": "\"[{"},
+      "a/b": {"~": 1, "c": 2}
+    })"sv;
+
+    const json::Projection projection{"/user/id"sv, "/items/*/price"sv, "/a~1b/~0"sv};
+    const Node expected{Dict{
+        {"user"s, Dict{{"id"s, 7}}},
+        {"items"s, Array{Dict{{"price"s, 1.5}}, Dict{}, Dict{{"price"s, 3}}}},
+        {"a/b"s, Dict{{"~"s, 1}}},
+    }};
+    assert(json::Load(text, projection).GetRoot() == expected);
+
+    // Пути через «*» продолжаются и под явно указанными ключами, префикс пути выбирает значение целиком
+    const json::Projection mixed{"/items/*/price"sv, "/items/1/title"sv, "/user"sv, "/user/id"sv};
+    const Node mixed_root = json::Load(text, mixed).GetRoot();
+    assert(mixed_root.AsMap().at("user"s) == json::Load(text).GetRoot().AsMap().at("user"s));
+    assert(mixed_root.AsMap().at("items"s).AsArray()[1] == (Node{Dict{{"title"s, "y"s}}}));
+
+    // Пропущенные элементы массива до выбранного заменяются на null, после него — отбрасываются
+    assert(json::Load("[10, 20, 30, 40]"sv, json::Projection{"/2"sv}).GetRoot() == (Node{Array{nullptr, nullptr, 30}}));
+    // Скаляр на промежуточном шаге пути не попадает в документ
+    assert(json::Load(R"({"user": 5, "items": [1, {"price": 2}]})"sv, projection).GetRoot() ==
+           (Node{Dict{{"items"s, Array{nullptr, Dict{{"price"s, 2}}}}}}));
+    assert(json::Load(R"({"user": 5})"sv, projection).GetRoot() == (Node{Dict{}}));
+    assert(json::Load(R"({"user": {"id": {"x": 1}}, "a/b": [1]})"sv, projection).GetRoot() ==
+           (Node{Dict{{"user"s, Dict{{"id"s, Dict{{"x"s, 1}}}}}, {"a/b"s, Array{}}}}));
+    assert(json::Load("5"sv, projection).GetRoot().IsNull());
+    // Пустой путь выбирает весь документ
+    assert(json::Load(text, json::Projection{""sv}).GetRoot() == json::Load(text).GetRoot());
+
+    // Грамматика выбранных значений и контейнеров на пути к ним проверяется полностью
+    assert(!json::TryLoad(R"({"user": {"id": tru}})"sv, projection));
+    assert(!json::TryLoad(R"({"user": {"id": 1} "x": 2})"sv, projection));
+    // Пропущенные значения проверяются так же, как при полном разборе
+    const json::Projection only_a{"/a"sv};
+    for (const std::string_view bad : {R"({"x": [1}, "a": 1})"sv, R"({"x": {"y": 1], "a": 1})"sv,
+                                       R"({"x": [tru, @@ ,,], "a": 1})"sv, R"({"x": [1 2 3], "a": 1})"sv,
+                                       R"({"x": [[1, 2], "a": 1})"sv, R"({"x": -, "a": 1})"sv,
+                                       R"({"x": 01, "a": 1})"sv, R"({"x": nul, "a": 1})"sv,
+                                       R"({"x": {"y" 1}, "a": 1})"sv, R"({"x": {1: 2}, "a": 1})"sv,
+                                       R"({"x": "\q", "a": 1})"sv})
+    {
+      assert(!json::TryLoad(bad));
+      assert(!json::TryLoad(bad, only_a));
+    }
+    const auto skipped = json::TryLoad(R"({"x": [true, null, -1.5e3, {"y": "A"}], "a": 1})"sv, only_a);
+    assert(skipped && skipped.GetValue().GetRoot() == (Node{Dict{{"a"s, 1}}}));
+
+    try
+    {
+      json::Projection bad{"user/id"sv};
+      assert(false);
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+    try
+    {
+      json::Projection bad{"/a~2"sv};
+      assert(false);
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+  }
+
+  [[maybe_unused]] void TestPath()
+  {
+    const Document doc = json::Load(R"({
+      "routes": [{"path": "/a", "handler": "h1"}, {"path": "/b", "handler": "h2", "auth": true}],
+      "a/b": {"m~n": 1},
+      "version": 3
+    })"sv);
+    const Node &root = doc.GetRoot();
+
+    const json::Path handler("/routes/1/handler"sv);
+    assert(handler.Find(root) == &root.AsMap().at("routes"s).AsArray()[1].AsMap().at("handler"s));
+    assert(handler.Find(root)->AsString() == "h2"s);
+    assert(json::Path("/a~1b/m~0n"sv).Find(root)->AsInt() == 1);
+    assert(json::Path(""sv).Find(root) == &root);
+    assert(json::Path("/routes/2/handler"sv).Find(root) == nullptr);
+    assert(json::Path("/routes/01"sv).Find(root) == nullptr);
+    assert(json::Path("/version/x"sv).Find(root) == nullptr);
+
+    const json::Path all_paths("/routes/*/path"sv);
+    std::vector<const Node *> found;
+    all_paths.FindAll(root, found);
+    assert(found.size() == 2 && found[0]->AsString() == "/a"s && found[1]->AsString() == "/b"s);
+    assert(all_paths.Find(root)->AsString() == "/a"s);
+
+    // Все пути вычисляются за один обход документа
+    const json::PathSet set({json::Path("/version"sv), json::Path("/routes/*/auth"sv), json::Path("/routes/0/path"sv),
+                             json::Path("/missing"sv), json::Path("/routes/1"sv), json::Path("/*/m~0n"sv)});
+    std::vector<const Node *> results;
+    set.Evaluate(root, results);
+    assert(results.size() == set.Size());
+    assert(results[0] == &root.AsMap().at("version"s));
+    assert(results[1] != nullptr && results[1]->AsBool());
+    assert(results[2]->AsString() == "/a"s);
+    assert(results[3] == nullptr);
+    assert(results[4] == &root.AsMap().at("routes"s).AsArray()[1]);
+    assert(results[5]->AsInt() == 1);
+
+    try
+    {
+      json::Path bad("routes"sv);
+      assert(false);
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+  }
+
+  [[maybe_unused]] void TestFlatDict()
+  {
+    using FlatDict = json::FlatDict<int>;
+
+    // Ключи упорядочены, из повторяющихся остаётся первый, как при вставке в std::map
+    const FlatDict dict{{"b"s, 2}, {"a"s, 1}, {"c"s, 3}, {"a"s, 10}};
+    assert(dict.size() == 3);
+    std::string keys;
+    int sum = 0;
+    for (const auto &[key, value] : dict)
+    {
+      keys += key;
+      sum += value;
+    }
+    assert(keys == "abc"s && sum == 6);
+    assert(dict.at("a"sv) == 1);
+    assert(dict.find("d"sv) == dict.end());
+    assert(dict.count("c"sv) == 1);
+    try
+    {
+      dict.at("d"sv);
+      assert(false);
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+
+    FlatDict copy = dict;
+    assert(copy == dict);
+    assert(!copy.emplace("b"s, 20).second && copy.at("b"sv) == 2);
+    assert(copy.emplace("ab"s, 5).second);
+    assert(copy != dict);
+    assert(copy.erase("ab"sv) == 1 && copy == dict);
+    copy["z"sv] = 26;
+    assert(std::prev(copy.end())->first == "z"s);
+
+    // Как и у std::map, через итератор меняется только значение, ключ константен
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(copy.begin()->first)>>);
+    static_assert(std::is_same_v<FlatDict::value_type, std::pair<const std::string, int>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype((*dict.begin()).second)>>);
+    copy.begin()->second = 100;
+    (*std::next(copy.begin())).second += 1;
+    assert(copy.at("a"sv) == 100 && copy.at("b"sv) == 3);
+    const FlatDict::value_type first = *copy.begin();
+    assert(first.first == "a"s && first.second == 100);
+    const FlatDict::const_iterator last = std::prev(copy.end());
+    const FlatDict::iterator after = copy.erase(last);
+    assert(after == copy.end() && copy.size() == 3);
+
+    // Больше kLinearScanLimit ключей ищутся двоичным поиском
+    FlatDict big;
+    for (int i = 99; i >= 0; --i)
+    {
+      big.emplace(std::to_string(i), i);
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+      assert(big.at(std::to_string(i)) == i);
+    }
+    assert(big.find("100"sv) == big.end());
+    assert(std::is_sorted(big.begin(), big.end()));
+  }
+
+  [[maybe_unused]] void TestKeyInterning()
+  {
+    using json::Key;
+
+    // Одинаковые строки дают один и тот же экземпляр ключа
+    const Key a("status"sv);
+    const Key b("status"s);
+    assert(a == b && &a.GetString() == &b.GetString());
+    assert(a == "status"sv && "status"s == a && a != "state"sv);
+    assert(Key("abc"sv) < Key("abd"sv) && !(Key("abd"sv) < Key("abc"sv)));
+    assert(Key().GetString().empty());
+    const std::string_view view = a;
+    assert(view == "status"sv);
+
+    // Таблицей можно пользоваться из нескольких потоков
+    const auto &shared = json::KeyTable::Shared();
+    const size_t size_before = shared->Size();
+    {
+      std::vector<std::thread> threads;
+      std::vector<std::vector<Key>> keys(4);
+      for (size_t t = 0; t < keys.size(); ++t)
+      {
+        threads.emplace_back([t, &keys]
+                             {
+                               for (int i = 0; i < 1000; ++i)
+                               {
+                                 keys[t].emplace_back("interning test key "s + std::to_string(i));
+                               }
+                               // Ключ, который то исчезает, то появляется снова
+                               for (int i = 0; i < 10000; ++i)
+                               {
+                                 const Key churn("interning churn"sv);
+                                 assert(churn == "interning churn"sv);
+                               } });
+      }
+      for (auto &thread : threads)
+      {
+        thread.join();
+      }
+      assert(shared->Size() == size_before + 1000);
+      for (const auto &thread_keys : keys)
+      {
+        assert(thread_keys == keys[0] && &thread_keys[7].GetString() == &keys[0][7].GetString());
+      }
+    }
+    // Строки без ключей удаляются из таблицы
+    assert(shared->Size() == size_before);
+
+    // Ключи разных таблиц с одинаковыми строками равны
+    const auto table = json::KeyTable::Create();
+    const Key local = table->Intern("status"sv);
+    assert(local == a && &local.GetString() != &a.GetString() && table->Size() == 1);
+    assert(!(local < a) && !(a < local) && local != table->Intern("state"sv));
+    Key moved = local;
+    const Key taken = std::move(moved);
+    assert(taken == local && moved.GetString().empty() && moved == Key());
+    assert(table->Intern(""sv) == Key() && table->Size() == 1);
+
+    // Разобранные документы по умолчанию не заносят ключи в общую таблицу
+    const auto doc = json::Load(R"({"scoped key 1": 1, "scoped key 2": {"scoped key 1": 2}})"sv);
+    assert(shared->Size() == size_before);
+    assert(doc.GetRoot().AsMap().at("scoped key 2"s).AsMap().count("scoped key 1"s) == 1);
+    const json::Document copy = doc;
+    assert(copy.GetRoot() == doc.GetRoot());
+#ifdef JSON_INTERN_KEYS
+    // Общую таблицу можно передать явно
+    {
+      json::Loader shared_loader(json::ParseOptions{json::ParseOptions::kDefaultMaxDepth, shared});
+      const auto shared_doc = shared_loader.Load(R"({"scoped key 1": 1})"sv);
+      assert(shared->Size() == size_before + 1);
+      assert(shared_doc.GetRoot().AsMap().begin()->first == doc.GetRoot().AsMap().begin()->first);
+    }
+    assert(shared->Size() == size_before);
+#endif
+
+    // Словарь с общими ключами ведёт себя как обычный
+    using KeyDict = json::FlatDict<int, Key>;
+    const KeyDict dict{{"b"s, 2}, {"a"s, 1}, {"b"s, 3}};
+    assert(dict.size() == 2 && dict.at("b"sv) == 2);
+    assert(dict.begin()->first == "a"sv);
+    assert(dict == (KeyDict{{"a"s, 1}, {"b"s, 2}}));
+  }
+
+  [[maybe_unused]] void TestBorrowedStrings()
+  {
+    auto text = std::make_shared<const std::string>(R"({"plain": "hello", "escaped": "a\nb", "list": ["x", "y"]})"s);
+    const char *const begin = text->data();
+    const char *const end = begin + text->size();
+    const auto in_source = [begin, end](const Node &node)
+    {
+      const std::string_view value = node.AsStringView();
+      return value.data() >= begin && value.data() + value.size() <= end;
+    };
+
+    std::weak_ptr<const std::string> watch = text;
+    Document doc = json::Load(std::move(text));
+    const Dict &root = doc.GetRoot().AsMap();
+
+    // Строки без escape-последовательностей ссылаются на исходный буфер
+    const Node &plain = root.at("plain"s);
+    assert(plain.IsString() && plain.IsBorrowedString());
+    assert(plain.AsStringView() == "hello"sv && in_source(plain));
+    // Объекта std::string у них нет: AsString сообщает об ошибке, копия узла владеет строкой
+    MustThrowLogicError([&plain]
+                        { plain.AsString(); });
+    assert(Node(plain).AsString() == "hello"s && plain.IsBorrowedString());
+    assert(in_source(root.at("list"s).AsArray()[1]));
+
+    // Раскодированные строки принадлежат узлу
+    const Node &escaped = root.at("escaped"s);
+    assert(!escaped.IsBorrowedString() && escaped.AsString() == "a\nb"s);
+
+    // Заимствованные и собственные строки равны при равном содержимом и печатаются одинаково
+    const std::string copy = R"({"plain": "hello", "escaped": "a\nb", "list": ["x", "y"]})"s;
+    assert(doc.GetRoot() == json::Load(copy).GetRoot());
+    assert(Print(doc.GetRoot()) == Print(json::Load(copy).GetRoot()));
+    const Node node_copy = plain;
+    assert(!node_copy.IsBorrowedString() && node_copy == Node{"hello"s} && !in_source(node_copy));
+
+    // Документ и его копии продлевают жизнь буфера
+    assert(!watch.expired());
+    {
+      Document doc_copy = doc;
+      doc = Document(Node{});
+      assert(!watch.expired());
+      assert(doc_copy.GetRoot().AsMap().at("plain"s).AsStringView() == "hello"sv);
+    }
+    assert(watch.expired());
+
+    // Узлы, скопированные из документа, не зависят от буфера
+    auto source = std::make_shared<const std::string>(R"(["escaping", {"key": "value"}])"s);
+    watch = source;
+    Node escaped_root = json::Load(std::move(source)).GetRoot();
+    assert(watch.expired());
+    assert(escaped_root.AsArray()[0].AsString() == "escaping"s);
+    assert(escaped_root.AsArray()[1].AsMap().at("key"s).AsStringView() == "value"sv);
+
+    // Изменяемый корень не ссылается на буфер, и узлы из него можно перемещать
+    source = std::make_shared<const std::string>(R"(["moved"])"s);
+    watch = source;
+    Document mutable_doc = json::Load(std::move(source));
+    Node moved = std::move(mutable_doc.GetMutableRoot().AsArray()[0]);
+    assert(watch.expired() && !moved.IsBorrowedString() && moved.AsString() == "moved"s);
+
+    // Ошибка разбора не задерживает буфер
+    auto broken = std::make_shared<const std::string>("[\"a\", "s);
+    const std::string_view broken_view = *broken;
+    assert(!json::TryLoad(broken_view, broken));
+  }
+
+  // Позиции токенов, найденные посимвольным обходом входа
+  std::vector<uint32_t> ReferenceTokens(std::string_view input)
+  {
+    std::vector<uint32_t> result;
+    bool in_string = false;
+    bool escaped = false;
+    bool in_scalar = false;
+    for (uint32_t i = 0; i < input.size(); ++i)
+    {
+      const char c = input[i];
+      if (in_string)
+      {
+        if (escaped)
+        {
+          escaped = false;
+        }
+        else if (c == '\\')
+        {
+          escaped = true;
+        }
+        else if (c == '"')
+        {
+          in_string = false;
+        }
+        continue;
+      }
+      const bool is_space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+      const bool is_op = std::string_view("{}[]:,").find(c) != std::string_view::npos;
+      if (c == '"')
+      {
+        in_string = true;
+        result.push_back(i);
+      }
+      else if (is_op || (!is_space && !in_scalar))
+      {
+        result.push_back(i);
+      }
+      in_scalar = !is_space && !is_op && c != '"';
+    }
+    return result;
+  }
+
+  // Создаёт временный файл с содержимым text и возвращает его имя
+  std::string WriteTempFile(const std::string &text)
+  {
+    char name[] = "/tmp/json_test_XXXXXX";
+    const int fd = mkstemp(name);
+    assert(fd >= 0);
+    std::FILE *file = fdopen(fd, "wb");
+    assert(file != nullptr);
+    assert(std::fwrite(text.data(), 1, text.size(), file) == text.size());
+    std::fclose(file);
+    return name;
+  }
+
+  [[maybe_unused]] void TestLoadFile()
+  {
+    const std::string path = WriteTempFile(R"({"name": "mapped", "escaped": "a\tb", "list": [1, 2.5, null]})"s);
+    {
+      std::weak_ptr<const MappedFile> watch;
+      {
+        const auto file = MappedFile::Open(path);
+        assert(file->IsMapped());
+        watch = file;
+      }
+      assert(watch.expired());
+
+      // Строки принадлежат узлам, и файл закрывается сразу после разбора
+      const Node root = LoadFile(path).GetRoot();
+      assert(!root.AsMap().at("name"s).IsBorrowedString() && root.AsMap().at("name"s).AsString() == "mapped"s);
+      assert(root.AsMap().at("escaped"s).AsString() == "a\tb"s);
+      assert(root.AsMap().at("list"s) == (Node{Array{1, 2.5, nullptr}}));
+
+      // LoadMappedFile оставляет строки в отображённом файле, который живёт вместе с документом
+      const Document doc = LoadMappedFile(path);
+      const Dict &mapped = doc.GetRoot().AsMap();
+      assert(mapped.at("name"s).IsBorrowedString() && mapped.at("name"s).AsStringView() == "mapped"sv);
+      assert(mapped.at("escaped"s).AsString() == "a\tb"s);
+      assert(doc.GetRoot() == root);
+      assert(TryLoadMappedFile(path).GetValue().GetRoot() == root);
+    }
+
+    // Пустой файл открывается, но документом не является
+    const std::string empty_path = WriteTempFile(""s);
+    assert(MappedFile::Open(empty_path)->GetData().empty());
+    assert(TryLoadFile(empty_path).GetError().code == ParseErrorCode::UnexpectedEnd);
+
+    // Канал отобразить нельзя, он читается через read()
+    const std::string fifo_path = path + ".fifo"s;
+    assert(mkfifo(fifo_path.c_str(), 0600) == 0);
+    assert(MappedFile::TryMap(path) != nullptr);
+    std::thread writer([&fifo_path]
+                       {
+                         std::FILE *fifo = std::fopen(fifo_path.c_str(), "wb");
+                         assert(fifo != nullptr);
+                         const std::string text = "[\"piped\", 7]"s;
+                         std::fwrite(text.data(), 1, text.size(), fifo);
+                         std::fclose(fifo); });
+    const auto piped = MappedFile::Open(fifo_path);
+    writer.join();
+    assert(!piped->IsMapped() && piped->GetData() == "[\"piped\", 7]"sv);
+    assert(json::Load(piped->GetData()).GetRoot() == (Node{Array{"piped"s, 7}}));
+
+    // Отображённый файл JSON Lines читается без копирования в буфер
+    const std::string lines_path = WriteTempFile("1\n\n[2]\n{\"a\": 3}"s);
+    LinesReader reader(lines_path);
+    assert(reader.Next()->GetRoot() == Node{1});
+    assert(reader.Next()->GetRoot() == (Node{Array{2}}));
+    assert(reader.Next()->GetRoot() == (Node{Dict{{"a"s, 3}}}));
+    assert(reader.GetLineNumber() == 4 && !reader.Next());
+
+    try
+    {
+      LoadFile(path + ".missing"s);
+      assert(false);
+    }
+    catch (const std::system_error &e)
+    {
+      assert(e.code() == std::errc::no_such_file_or_directory);
+    }
+
+    for (const std::string &name : {path, empty_path, fifo_path, lines_path})
+    {
+      std::remove(name.c_str());
+    }
+  }
+
+  [[maybe_unused]] void TestStructuralIndex()
+  {
+    using namespace json::detail;
+
+    std::string input;
+    for (int i = 0; i < 300; ++i)
+    {
+      // Серии обратных косых разной длины попадают на границы 64-байтных блоков
+      input += "{\"k"s + std::to_string(i) + "\":[" + std::to_string(i * 7) + ",true,\"" +
+               std::string(i % 5, '\\') + std::string(i % 5, '\\') + "\\\"x\\\\\"] , null }\n"s;
+    }
+    const auto expected = ReferenceTokens(input);
+    for (ScanKernel kernel : {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2})
+    {
+      if (!IsScanKernelSupported(kernel))
+      {
+        continue;
+      }
+      StructuralScanner scanner(kernel);
+      std::vector<uint32_t> positions(input.size() + StructuralScanner::kBlockSize);
+      positions.resize(scanner.Scan(input.data(), input.size(), positions.data()));
+      assert(positions == expected);
+      assert(!scanner.InString());
+    }
+
+    // Документ, индекс которого строится несколькими окнами
     Array arr;
-    int num = 1;
-    arr.reserve(num);
-    for (int i = 0; i < num; ++i)
-    {
-      arr.emplace_back(Dict{
-          {"int"s, 42},
-          {"double"s, 42.1},
-          {"null"s, nullptr},
-          {"string"s, "hello"s},
-          {"array"s, Array{1, 2, 3}},
-          {"bool"s, true},
-          {"map"s, Dict{{"key"s, "value"s}}},
-      });
-    }
-    std::stringstream strm;
-    Document _doc{arr};
-    json::Print(_doc, strm);
-    std::string strm_str = strm.str();
-    const auto doc = json::Load(strm);
-    assert(doc.GetRoot() == arr);
-    const auto duration = std::chrono::steady_clock::now() - start;
-    std::cout
-        << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()
-        << "ms"sv << std::endl;
+    std::string text = "["s;
+    for (int i = 0; i < 20000; ++i)
+    {
+      arr.emplace_back(Dict{{"id"s, i}, {"name"s, "item \\ \"" + std::to_string(i) + "\""s}});
+      text += (i == 0 ? ""s : ", "s) + Print(arr.back());
+    }
+    text += "]"s;
+    assert(text.size() > TokenCursor::kDefaultWindow * 4);
+    assert(json::Load(text).GetRoot() == Node{arr});
+  }
+
+  [[maybe_unused]] void TestStringScanning()
+  {
+    using namespace json::detail;
+
+    // Специальный символ в каждой позиции строк разной длины, в том числе у самого конца,
+    // чтобы проверить блоки по 16 и 32 байта и их хвосты
+    for (const char special : {'"', '\\', '\n', '\t', '\x01', '\x1f'})
+    {
+      for (size_t size = 0; size <= 70; ++size)
+      {
+        for (size_t pos = 0; pos <= size; ++pos)
+        {
+          std::string text(size, 'a');
+          // Байты старше 0x7f не являются управляющими символами
+          if (size > 2)
+          {
+            text[size / 2] = '\xe9';
+          }
+          if (pos < size)
+          {
+            text[pos] = special;
+          }
+          const char *begin = text.data();
+          for (ScanKernel kernel : {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2})
+          {
+            assert(FindStringSpecial(begin, begin + size, kernel) == begin + pos);
+          }
+          assert(FindStringSpecial(begin, begin + size) == begin + pos);
+        }
+      }
+    }
+
+    // Длинные строки печатаются и разбираются так же, как посимвольно
+    std::string value;
+    for (int i = 0; i < 300; ++i)
+    {
+      value += std::string(static_cast<size_t>(i % 40), 'x') + (i % 3 == 0 ? "\""s : i % 3 == 1 ? "\\\t"s : "\n\r"s);
+    }
+    const std::string printed = Print(Node{value});
+    assert(printed.find('\n') == std::string::npos && printed.find('\r') == std::string::npos);
+    assert(printed.find("\\\"x"s) != std::string::npos && printed.find("\\\\\\t"s) != std::string::npos);
+    assert(json::Load(printed).GetRoot() == Node{value});
+
+    // Неэкранированная табуляция внутри строки допустима, перевод строки — нет
+    const std::string tabs = "\""s + std::string(40, 'y') + "\t"s + std::string(40, 'y') + "\""s;
+    assert(json::Load(tabs).GetRoot().AsString().size() == 81);
+    const std::string broken = "\""s + std::string(40, 'y') + "\n\""s;
+    assert(json::TryLoad(broken).GetError().code == json::ParseErrorCode::NewlineInString);
+    assert(json::TryLoad(broken).GetError().offset == 41);
+  }
+
+  // Считает блоки, которые арена запрашивает у вышестоящего ресурса
+  class CountingResource : public std::pmr::memory_resource
+  {
+  public:
+    size_t allocations = 0;
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+      ++allocations;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+      return this == &other;
+    }
+  };
+
+  [[maybe_unused]] void TestPmrDocument()
+  {
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i)
+    {
+      text += (i == 0 ? ""s : ","s) + R"({"id":)" + std::to_string(i) +
+              R"(,"name":"a fairly long string value that does not fit into SSO","tags":["x","y"],"ok":true,"v":0.5,"n":null})";
+    }
+    text += "]";
+
+    CountingResource upstream;
+    {
+      const json::pmr::Document doc = json::pmr::Load(text, &upstream);
+      const auto &root = doc.GetRoot();
+      assert(root.IsArray());
+      assert(root.AsArray().size() == 1000);
+      const auto &item = root.AsArray()[7].AsMap();
+      assert(item.find("id"sv)->second.AsInt() == 7);
+      assert(item.find("ok"sv)->second.AsBool());
+      assert(item.find("n"sv)->second.IsNull());
+      assert(item.find("tags"sv)->second.AsArray()[1].AsString() == "y"sv);
+      assert(json::pmr::ToNode(root) == json::Load(text).GetRoot());
+      assert(item.get_allocator().resource() == doc.GetResource());
+    }
+    // Тысячи узлов размещены в нескольких больших блоках
+    assert(upstream.allocations > 0 && upstream.allocations < 16);
+
+    json::pmr::Document moved = json::pmr::Load("{\"a\": [1, \"b\"]}"sv);
+    json::pmr::Document doc = std::move(moved);
+    assert(doc.GetRoot().AsMap().at(json::pmr::String("a")).AsArray()[1].AsString() == "b"sv);
+    // Перемещённый документ не ссылается на чужую арену
+    assert(moved.GetRoot().IsNull() && moved.GetResource() == nullptr);
+    moved = json::pmr::Load("[true]"sv);
+    doc = std::move(moved);
+    assert(doc.GetRoot().AsArray()[0].AsBool() && moved.GetRoot().IsNull());
+    try
+    {
+      json::pmr::Load("[1, {\"a\": }]"sv);
+      assert(false);
+    }
+    catch (const json::ParsingError &)
+    {
+      // ok
+    }
+  }
+
+  [[maybe_unused]] void TestPrintTargets()
+  {
+    // Числа с плавающей запятой выводятся в кратчайшем виде без потери точности
+    assert(Print(Node{123.456789}) == "123.456789"s);
+    assert(Print(Node{0.1}) == "0.1"s);
+    assert(LoadJSON(Print(Node{1e300})).GetRoot().AsDouble() == 1e300);
+    assert(Print(Node{Dict{{"a\"b"s, 1}}}) == R"({"a\"b":1})"s);
+
+    Array big;
+    for (int i = 0; i < 20000; ++i)
+    {
+      big.emplace_back(Array{i, "value \t "s + std::to_string(i), i + 0.5});
+    }
+    const Document doc{Node{big}};
+    const std::string expected = Print(doc.GetRoot());
+    assert(expected.size() > OutputBuffer::kCapacity);
+
+    std::string to_string = "prefix"s;
+    json::Print(doc, to_string);
+    assert(to_string == "prefix"s + expected);
+
+    std::FILE *file = std::tmpfile();
+    assert(file != nullptr);
+    json::Print(doc, fileno(file));
+    std::rewind(file);
+    std::string from_file(expected.size() + 1, '\0');
+    from_file.resize(std::fread(from_file.data(), 1, from_file.size(), file));
+    std::fclose(file);
+    assert(from_file == expected);
+    assert(json::Load(from_file).GetRoot() == Node{big});
+  }
+
+  // Собирает статистику по документу, не строя дерево
+  struct CountingHandler : json::BaseHandler
+  {
+    int values = 0;
+    int depth = 0;
+    int max_depth = 0;
+    long long int_sum = 0;
+    std::string keys;
+
+    void OnInt(int value)
+    {
+      ++values;
+      int_sum += value;
+    }
+    void OnString(std::string_view) { ++values; }
+    void OnNull() { ++values; }
+    void OnKey(std::string_view key) { keys += key; }
+    void OnStartArray() { Enter(); }
+    void OnEndArray() { --depth; }
+    void OnStartObject() { Enter(); }
+    void OnEndObject() { --depth; }
+
+    void Enter()
+    {
+      ++values;
+      max_depth = std::max(max_depth, ++depth);
+    }
+  };
+
+  [[maybe_unused]] void TestSaxParse()
+  {
+    const auto text = R"({"a": [1, 2, {"b\tc": 3}], "d": "str\n", "e": null, "f": 1.5, "g": true})"sv;
+    CountingHandler handler;
+    json::Parse(text, handler);
+    assert(handler.values == 8);
+    assert(handler.depth == 0);
+    assert(handler.max_depth == 3);
+    assert(handler.int_sum == 6);
+    // События приходят в порядке следования в документе
+    assert(handler.keys == "ab\tcdefg"s);
+
+    // Обработчик, которому нужны все события
+    struct Recorder
+    {
+      std::string events;
+      void OnNull() { events += 'n'; }
+      void OnBool(bool value) { events += value ? 'T' : 'F'; }
+      void OnInt(int) { events += 'i'; }
+      void OnInt64(int64_t) { events += 'l'; }
+      void OnUint64(uint64_t) { events += 'u'; }
+      void OnDouble(double) { events += 'd'; }
+      void OnString(std::string_view value) { events += "s("s + std::string(value) + ")"s; }
+      void OnKey(std::string_view key) { events += "k("s + std::string(key) + ")"s; }
+      void OnStartArray() { events += '['; }
+      void OnEndArray() { events += ']'; }
+      void OnStartObject() { events += '{'; }
+      void OnEndObject() { events += '}'; }
+    };
+    Recorder recorder;
+    const std::string input = R"([{"x": "\"q\""}, [], {}, false, 7, -0.5, 4294967296, 9223372036854775808])"s;
+    json::Parse(input.data(), input.size(), recorder);
+    assert(recorder.events == R"([{k(x)s("q")}[]{}Fidlu])"s);
+
+    try
+    {
+      CountingHandler failing;
+      json::Parse("[1, 2"sv, failing);
+      assert(false);
+    }
+    catch (const json::ParsingError &)
+    {
+      // ok
+    }
+  }
+
+  [[maybe_unused]] void TestLinesReader()
+  {
+    const std::string long_value(100, 'x');
+    std::istringstream input("{\"a\": 1}\n\n  \r\n[1, 2]\r\n\"" + long_value + "\"\nnull"s);
+    // Маленькая порция чтения заставляет буфер дочитываться и расти
+    LinesReader reader(input, 16);
+    auto doc = reader.Next();
+    assert(doc && doc->GetRoot() == (Node{Dict{{"a"s, 1}}}));
+    assert(reader.GetLineNumber() == 1);
+
+    std::vector<Document> batch;
+    assert(reader.NextBatch(batch, 2) == 2);
+    assert(batch[0].GetRoot() == (Node{Array{1, 2}}));
+    assert(batch[1].GetRoot() == Node{long_value});
+    assert(reader.GetLineNumber() == 5);
+    assert(reader.NextBatch(batch, 2) == 1);
+    assert(batch[0].GetRoot().IsNull());
+    assert(!reader.Next());
+    assert(reader.NextBatch(batch, 2) == 0);
+
+    std::istringstream broken("1\n2\n[3,\n4\n"s);
+    LinesReader broken_reader(broken);
+    assert(broken_reader.Next()->GetRoot() == Node{1});
+    assert(broken_reader.Next()->GetRoot() == Node{2});
+    try
+    {
+      broken_reader.Next();
+      assert(false);
+    }
+    catch (const ParsingError &e)
+    {
+      assert(std::string_view(e.what()).substr(0, 7) == "line 3:"sv);
+    }
+    // После ошибки чтение продолжается со следующей строки
+    assert(broken_reader.Next()->GetRoot() == Node{4});
+  }
+
+  [[maybe_unused]] void TestReadLinesParallel()
+  {
+    std::string text;
+    for (int i = 1; i <= 5000; ++i)
+    {
+      text += R"({"id": )"s + std::to_string(i) + R"(, "pad": ")"s + std::string(i % 50, 'p') + "\"}\n"s;
+      if (i % 1000 == 0)
+      {
+        text += "\n"s;
+      }
+    }
+
+    ParallelReadOptions options;
+    options.threads = 4;
+    options.chunk_size = 512;
+
+    std::vector<int> ids;
+    size_t prev_line = 0;
+    std::istringstream ordered_input(text);
+    ReadLinesParallel(
+        ordered_input, [&](Document &&doc, size_t line)
+        {
+          assert(line > prev_line);
+          prev_line = line;
+          ids.push_back(doc.GetRoot().AsMap().at("id"s).AsInt()); },
+        options);
+    std::vector<int> expected(5000);
+    std::iota(expected.begin(), expected.end(), 1);
+    assert(ids == expected);
+
+    options.order = DeliveryOrder::Unordered;
+    std::mutex mutex;
+    ids.clear();
+    std::istringstream unordered_input(text);
+    ReadLinesParallel(
+        unordered_input, [&](Document &&doc, size_t)
+        {
+          std::lock_guard lock(mutex);
+          ids.push_back(doc.GetRoot().AsMap().at("id"s).AsInt()); },
+        options);
+    std::sort(ids.begin(), ids.end());
+    assert(ids == expected);
+
+    // Ошибка в середине входа: до неё переданы все предшествующие документы
+    options.order = DeliveryOrder::Ordered;
+    const size_t cut = text.rfind('\n', 3000) + 1;
+    std::istringstream broken(text.substr(0, cut) + "{broken\n"s + text);
+    size_t delivered = 0;
+    try
+    {
+      ReadLinesParallel(
+          broken, [&](Document &&, size_t)
+          { ++delivered; },
+          options);
+      assert(false);
+    }
+    catch (const ParsingError &e)
+    {
+      assert(std::string_view(e.what()).substr(0, 5) == "line "sv);
+    }
+    assert(delivered == static_cast<size_t>(std::count(text.begin(), text.begin() + cut, '\n')));
+  }
+
+  const profile::Entry *FindEntry(const std::vector<profile::Entry> &entries, std::string_view path)
+  {
+    const auto it = std::find_if(entries.begin(), entries.end(), [path](const profile::Entry &entry)
+                                 { return entry.path == path; });
+    return it != entries.end() ? &*it : nullptr;
+  }
+
+  [[maybe_unused]] void TestLogDuration()
+  {
+    profile::Reset();
+    const auto inner = []
+    {
+      LOG_DURATION_STATIC("test::inner");
+    };
+    for (int i = 0; i < 10; ++i)
+    {
+      LOG_DURATION("test::outer");
+      inner();
+      inner();
+    }
+    // Та же метка вне outer — отдельный путь
+    inner();
+    std::thread worker([&]
+                       {
+                         for (int i = 0; i < 5; ++i)
+                         {
+                           LOG_DURATION("test::outer");
+                           inner();
+                         } });
+    worker.join();
+
+    const auto entries = profile::Collect();
+    const profile::Entry *outer = FindEntry(entries, "test::outer"sv);
+    const profile::Entry *nested = FindEntry(entries, "test::outer/test::inner"sv);
+    const profile::Entry *top = FindEntry(entries, "test::inner"sv);
+    assert(outer != nullptr && nested != nullptr && top != nullptr);
+    assert(outer->count == 15 && outer->depth == 0);
+    assert(nested->count == 25 && nested->depth == 1 && nested->label == "test::inner"s);
+    assert(top->count == 1);
+    // Длительности зависят от машины, поэтому проверяется только их порядок: вложенные области
+    // укладываются во внешние, а перцентили не выходят за наименьшее и наибольшее значения
+    assert(nested->min_ns <= nested->p50_ns && nested->p50_ns <= nested->p90_ns &&
+           nested->p90_ns <= nested->p99_ns && nested->p99_ns <= nested->max_ns);
+    assert(nested->total_ns >= 25 * nested->min_ns && outer->total_ns >= nested->total_ns);
+    assert(outer - &entries[0] < nested - &entries[0]);
+
+    // Метка, вычисляемая во время работы, учитывается при каждом входе заново
+    for (const std::string &label : {"test::runtime-a"s, "test::runtime-b"s, "test::runtime-a"s})
+    {
+      LOG_DURATION(label);
+    }
+    // Место замера ищет метку в общей таблице, только когда та меняется
+    profile::detail::SiteCache cache;
+    const profile::SiteId cached = cache.Get("test::runtime-a"sv).GetId();
+    assert(cache.Get("test::runtime-a"s).GetId() == cached);
+    assert(cache.Get("test::runtime-b"sv).GetId() != cached && cache.Get("test::runtime-a"sv).GetId() == cached);
+    // Макрос раскрывается в одно объявление
+    if (!entries.empty())
+      LOG_DURATION("test::if"s);
+    {
+      LogDuration guard("test::guard"s);
+    }
+    // Статистика потоков переносится в общую при их завершении
+    for (int i = 0; i < 8; ++i)
+    {
+      std::thread([]
+                  { LOG_DURATION_STATIC("test::thread"); })
+          .join();
+    }
+    const auto runtime_entries = profile::Collect();
+    assert(FindEntry(runtime_entries, "test::runtime-a"sv)->count == 2);
+    assert(FindEntry(runtime_entries, "test::runtime-b"sv)->count == 1);
+    assert(FindEntry(runtime_entries, "test::if"sv)->count == 1);
+    assert(FindEntry(runtime_entries, "test::guard"sv)->count == 1);
+    assert(FindEntry(runtime_entries, "test::thread"sv)->count == 8);
+    assert(FindEntry(runtime_entries, "test::outer/test::inner"sv)->count == 25);
+
+    // Нулевые и очень короткие замеры, которые дают грубые часы, попадают в точные корзины
+    profile::detail::Node zero(0, 0);
+    for (const uint64_t ns : {0, 0, 0, 3, 5})
+    {
+      zero.Record(ns);
+    }
+    profile::detail::Aggregate aggregate;
+    aggregate.Add(zero);
+    assert(profile::detail::Percentile(aggregate.buckets, aggregate.count, 0.5) == 0);
+    assert(profile::detail::Percentile(aggregate.buckets, aggregate.count, 0.7) == 3);
+    assert(profile::detail::Percentile(aggregate.buckets, aggregate.count, 0.99) == 5);
+    for (size_t bucket = 1; bucket < profile::detail::kBuckets; ++bucket)
+    {
+      assert(profile::detail::BucketLowerBound(bucket - 1) <= profile::detail::BucketLowerBound(bucket));
+    }
+
+    std::ostringstream text;
+    profile::Dump(text);
+    assert(text.str().find("  test::inner"s) != std::string::npos);
+
+    std::ostringstream json_dump;
+    profile::Dump(json_dump, profile::DumpFormat::Json);
+    const auto doc = json::Load(json_dump.str());
+    bool found = false;
+    for (const Node &entry : doc.GetRoot().AsArray())
+    {
+      if (entry.AsMap().at("path"s).AsString() == "test::outer/test::inner"s)
+      {
+        found = true;
+        assert(entry.AsMap().at("count"s).AsInt() == 25);
+      }
+    }
+    assert(found);
+
+    profile::Reset();
+    assert(FindEntry(profile::Collect(), "test::outer"sv) == nullptr);
+    assert(FindEntry(profile::Collect(), "test::thread"sv) == nullptr);
+  }
+
+  [[maybe_unused]] void TestDocumentStats()
+  {
+    const std::string text = R"([null,true,1,5000000000,2.5,"short","a string long enough to need a heap buffer",)"s +
+                             R"({"key":[],"another key long enough for a heap buffer":{"x":"y"}}])"s;
+    const auto doc = json::Load(text);
+
+    const DocumentStats stats = doc.Stats();
+    assert(stats.nulls == 1 && stats.bools == 1 && stats.ints == 2 && stats.doubles == 1);
+    assert(stats.strings == 3 && stats.borrowed_strings == 0);
+    assert(stats.arrays == 2 && stats.dicts == 2 && stats.keys == 3);
+    assert(stats.Nodes() == 12);
+    assert(stats.unused_capacity_bytes < stats.allocated_bytes);
+#ifdef JSON_INTERN_KEYS
+    assert(stats.shared_key_bytes == 45 && stats.string_bytes == 48);
+#else
+    assert(stats.shared_key_bytes == 0 && stats.string_bytes == 93);
+#endif
+    assert(stats.OverheadBytes() == stats.allocated_bytes - stats.string_bytes);
+
+    // Строки без escape-последовательностей ссылаются на исходный буфер
+    const auto borrowed = json::Load(std::make_shared<const std::string>(R"(["abc","de"])"s));
+    const DocumentStats borrowed_stats = borrowed.Stats();
+    assert(borrowed_stats.borrowed_strings == 2 && borrowed_stats.borrowed_string_bytes == 5);
+    assert(borrowed_stats.string_bytes == 0);
+  }
+
+  [[maybe_unused]] void TestBuilder()
+  {
+    const Node built = Builder()
+                           .StartDict()
+                           .Key("name"sv)
+                           .Value("item"s)
+                           .Key("tags"sv)
+                           .StartArray()
+                           .Value(1)
+                           .Value(nullptr)
+                           .StartDict()
+                           .EndDict()
+                           .Value("x")
+                           .EndArray()
+                           .Key("size"sv)
+                           .StartDict()
+                           .Key("w"sv)
+                           .Value(2.5)
+                           .EndDict()
+                           .EndDict()
+                           .Build();
+    assert(built == json::Load(R"({"name":"item","tags":[1,null,{},"x"],"size":{"w":2.5}})"sv).GetRoot());
+    assert(Builder().Value(42).Build() == Node(42));
+
+    // Строки и контейнеры перемещаются в документ без копирования
+    std::string long_string(100, 'x');
+    const char *chars = long_string.data();
+    Array items(3, Node(1));
+    const Node *item = items.data();
+    const Node moved = Builder().StartArray().Value(std::move(long_string)).Value(std::move(items)).EndArray().Build();
+    assert(moved.AsArray()[0].AsString().data() == chars);
+    assert(moved.AsArray()[1].AsArray().data() == item);
+
+    const auto throws = [](auto &&build)
+    {
+      try
+      {
+        build();
+      }
+      catch (const std::logic_error &)
+      {
+        return true;
+      }
+      return false;
+    };
+    assert(throws([]
+                  { Builder().Build(); }));
+    assert(throws([]
+                  { Builder().StartArray().Build(); }));
+    assert(throws([]
+                  { Builder().Value(1).Value(2); }));
+    assert(throws([]
+                  { Builder().StartDict().Value(1); }));
+    assert(throws([]
+                  { Builder().StartDict().Key("a"sv).Key("b"sv); }));
+    assert(throws([]
+                  { Builder().StartDict().Key("a"sv).EndDict(); }));
+    assert(throws([]
+                  { Builder().StartArray().Key("a"sv); }));
+    assert(throws([]
+                  { Builder().StartArray().EndDict(); }));
+    assert(throws([]
+                  { Builder().StartDict().EndArray(); }));
+  }
+
+  [[maybe_unused]] void TestMutableNodes()
+  {
+    auto doc = json::Load(R"({"list":[1,2],"info":{"a":1}})"sv);
+    Node &root = doc.GetMutableRoot();
+    Array &list = root.AsMap().at("list"s).AsArray();
+    list.push_back(Node(3));
+    Node &nested = list.emplace_back(Array{});
+    nested.EmplaceBack("deep"s);
+    nested.EmplaceBack(Dict{}).Emplace("k"sv, true);
+
+    Node &info = root.AsMap().at("info"s);
+    // Существующий ключ не меняется
+    assert(info.Emplace("a"sv, 5) == Node(1));
+    info.Emplace("b"sv, Array{}).EmplaceBack(nullptr);
+    info.AsMap().erase("a"s);
+
+    assert(root == json::Load(R"({"list":[1,2,3,["deep",{"k":true}]],"info":{"b":[null]}})"sv).GetRoot());
+
+    // Строковые литералы и string_view становятся строками, а не bool
+    Node literals(Array{});
+    literals.EmplaceBack("text");
+    literals.EmplaceBack("view"sv);
+    literals.EmplaceBack(Dict{}).Emplace("k"sv, "v");
+    assert(Print(literals) == R"(["text","view",{"k":"v"}])"s);
+    assert(Node("x") == Node("x"s) && Node(nullptr).IsNull());
+
+    // Контейнер остаётся на месте, когда его узел перемещается
+    Node node(Array{});
+    Array *array = &node.AsArray();
+    Node other = std::move(node);
+    assert(&other.AsArray() == array);
+
+    bool thrown = false;
+    try
+    {
+      Node(1).EmplaceBack(2);
+    }
+    catch (const std::logic_error &)
+    {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+
+  [[maybe_unused]] void TestWriter()
+  {
+    std::string text;
+    {
+      Writer writer(text);
+      writer.StartDict().Key("rows"sv).StartArray();
+      for (int i = 0; i < 3; ++i)
+      {
+        writer.StartDict().Key("id"sv).Int(i).Key("name"sv).String("row \"" + std::to_string(i) + "\"\n").EndDict();
+      }
+      writer.EndArray();
+      assert(!writer.IsComplete());
+      writer.Key("big"sv).Uint(std::numeric_limits<uint64_t>::max()).Key("flags"sv).StartArray().Bool(true).Null().Double(0.5).EndArray();
+      writer.Key("empty"sv).StartDict().EndDict().Key("node"sv).Value(Node(Array{Node(1), Node("x"s)})).EndDict();
+      assert(writer.IsComplete());
+    }
+    assert(text == R"({"rows":[{"id":0,"name":"row \"0\"\n"},{"id":1,"name":"row \"1\"\n"},{"id":2,"name":"row \"2\"\n"}],)"s
+                   R"("big":18446744073709551615,"flags":[true,null,0.5],"empty":{},"node":[1,"x"]})"s);
+
+    // Поддерево пишется так же, как его печатает Print
+    const auto doc = json::Load(text);
+    std::string printed;
+    json::Print(doc, printed);
+    std::string written;
+    Writer(written).Value(doc.GetRoot());
+    assert(written == printed);
+
+    // Большой массив уходит в файл порциями, а не копится в памяти
+    char name[] = "/tmp/json_writer_XXXXXX";
+    const int fd = mkstemp(name);
+    assert(fd >= 0);
+    {
+      Writer writer(fd);
+      writer.StartArray();
+      for (int i = 0; i < 100000; ++i)
+      {
+        writer.StartArray().Int(i).String("value"sv).EndArray();
+      }
+      writer.EndArray();
+    }
+    ::close(fd);
+    const auto rows = json::LoadFile(name);
+    std::remove(name);
+    assert(rows.GetRoot().AsArray().size() == 100000);
+    assert(rows.GetRoot().AsArray().back() == Node(Array{Node(99999), Node("value"s)}));
+
+    std::string ignored;
+    const auto throws = [&ignored](auto &&write)
+    {
+      Writer writer(ignored);
+      try
+      {
+        write(writer);
+      }
+      catch (const std::logic_error &)
+      {
+        return true;
+      }
+      return false;
+    };
+    assert(throws([](Writer &w)
+                  { w.Int(1).Int(2); }));
+    assert(throws([](Writer &w)
+                  { w.StartDict().Int(1); }));
+    assert(throws([](Writer &w)
+                  { w.StartDict().Key("a"sv).Key("b"sv); }));
+    assert(throws([](Writer &w)
+                  { w.StartDict().Key("a"sv).EndDict(); }));
+    assert(throws([](Writer &w)
+                  { w.StartArray().Key("a"sv); }));
+    assert(throws([](Writer &w)
+                  { w.StartArray().EndDict(); }));
+    assert(throws([](Writer &w)
+                  { w.EndArray(); }));
   }
 } // namespace
 
@@ -296,10 +1748,33 @@ int main()
 {
   TestNull();
   TestNumbers();
+  TestInt64();
   TestStrings();
   TestBool();
   TestArray();
   TestMap();
   TestErrorHandling();
-  Benchmark();
+  TestLoadFromBuffer();
+  TestTryLoad();
+  TestBuilder();
+  TestMutableNodes();
+  TestPushParser();
+  TestDepthLimit();
+  TestLazyDocument();
+  TestProjection();
+  TestPath();
+  TestFlatDict();
+  TestKeyInterning();
+  TestBorrowedStrings();
+  TestLoadFile();
+  TestStructuralIndex();
+  TestStringScanning();
+  TestPmrDocument();
+  TestPrintTargets();
+  TestWriter();
+  TestSaxParse();
+  TestLinesReader();
+  TestReadLinesParallel();
+  TestLogDuration();
+  TestDocumentStats();
 }
\ No newline at end of file